@@ -22,6 +22,8 @@ static void ConsoleReadPoll(int c)
 { Console *console = (Console *)c; console->CheckCharAvail(); }
 static void ConsoleWriteDone(int c)
 { Console *console = (Console *)c; console->WriteDone(); }
+static void ConsoleDataReady(int c)
+{ Console *console = (Console *)c; console->DataReady(); }
 
 //----------------------------------------------------------------------
 // Console::Console
@@ -54,9 +56,10 @@ Console::Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail,
     handlerArg = callArg;
     putBusy = FALSE;
     incoming = EOF;
+    readScheduled = FALSE;
 
-    // start polling for incoming packets
-    interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime, ConsoleReadInt);
+    // have the host tell us when there are characters to read
+    WatchFile(readFileNo, ConsoleDataReady, (int)this);
 }
 
 //----------------------------------------------------------------------
@@ -66,16 +69,34 @@ Console::Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail,
 
 Console::~Console()
 {
+    UnwatchFile(readFileNo);
     if (readFileNo != 0)
 	Close(readFileNo);
     if (writeFileNo != 1)
 	Close(writeFileNo);
 }
 
+//----------------------------------------------------------------------
+// Console::DataReady()
+// 	Called by the host I/O multiplexer when the keyboard file has
+//	input.  Schedule the interrupt that reads it in, ConsoleTime from
+//	now, unless one is already on its way.
+//----------------------------------------------------------------------
+
+void
+Console::DataReady()
+{
+    if (readScheduled)
+	return;
+    readScheduled = TRUE;
+    interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime, 
+			ConsoleReadInt);
+}
+
 //----------------------------------------------------------------------
 // Console::CheckCharAvail()
-// 	Periodically called to check if a character is available for
-//	input from the simulated keyboard (eg, has it been typed?).
+// 	Called when input has arrived, to check if a character is available
+//	for input from the simulated keyboard (eg, has it been typed?).
 //
 //	Only read it in if there is buffer space for it (if the previous
 //	character has been grabbed out of the buffer by the Nachos kernel).
@@ -88,11 +109,10 @@ Console::CheckCharAvail()
 {
     char c;
 
-    // schedule the next time to poll for a packet
-    interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime, 
-			ConsoleReadInt);
+    readScheduled = FALSE;
 
     // do nothing if character is already buffered, or none to be read
+    // (if it is still there, the next host poll will bring us back)
     if ((incoming != EOF) || !PollFile(readFileNo))
 	return;	  
 
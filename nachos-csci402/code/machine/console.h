@@ -55,6 +55,7 @@ class Console {
 // internal emulation routines -- DO NOT call these. 
     void WriteDone();	 	// internal routines to signal I/O completion
     void CheckCharAvail();
+    void DataReady();		// the host keyboard file has input
 
   private:
     int readFileNo;			// UNIX file emulating the keyboard 
@@ -70,6 +71,8 @@ class Console {
     char incoming;    			// Contains the character to be read,
 					// if there is one available. 
 					// Otherwise contains EOF.
+    bool readScheduled;			// Is a CheckCharAvail interrupt
+					// already on its way?
 };
 
 #endif // CONSOLE_H
@@ -30,7 +30,8 @@ using namespace std;
 #include <iostream>
 static char *intLevelNames[] = { "off", "on"};
 static char *intTypeNames[] = { "timer", "disk", "console write", 
-			"console read", "network send", "network recv"};
+			"console read", "network send", "network recv",
+			"host I/O poll", "network timer", "alarm"};
 using namespace std;
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
@@ -50,6 +51,9 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int64_t time
     arg = param;
     when = time;
     type = kind;
+    order = 0;
+    heapIndex = -1;
+    nextFree = NULL;
 }
 
 //----------------------------------------------------------------------
@@ -62,7 +66,12 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int64_t time
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new List();
+    maxPending = 16;
+    pending = new PendingInterrupt *[maxPending];
+    numPending = 0;
+    numScheduled = 0;
+    nextDue = NoPendingInterrupt;
+    freeRecords = NULL;
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
@@ -75,9 +84,14 @@ Interrupt::Interrupt()
 
 Interrupt::~Interrupt()
 {
-    while (!pending->IsEmpty())
-	delete (PendingInterrupt *) pending->Remove();
-    delete pending;
+    for (int i = 0; i < numPending; i++)
+	delete pending[i];
+    delete [] pending;
+    while (freeRecords != NULL) {
+	PendingInterrupt *p = freeRecords;
+	freeRecords = p->nextFree;
+	delete p;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -148,25 +162,32 @@ Interrupt::Enable()
 //	Two things can cause OneTick to be called:
 //		interrupts are re-enabled
 //		a user instruction is executed
+//
+//	"ticks" is more than one when the threaded-code engine charges a
+//	whole block of user instructions at once.
 //----------------------------------------------------------------------
 void
-Interrupt::OneTick()
+Interrupt::OneTick(int ticks)
 {
     MachineStatus old = status;
 
 // advance simulated time
     if (status == SystemMode) 
     {
-        stats->totalTicks += (int64_t)SystemTick;
-	    stats->systemTicks += (int64_t)SystemTick;
+        stats->totalTicks += ticks * (int64_t)SystemTick;
+	    stats->systemTicks += ticks * (int64_t)SystemTick;
     } else 
     {					// USER_PROGRAM
-	    stats->totalTicks += (int64_t)UserTick;
-	    stats->userTicks += (int64_t)UserTick;
+	    stats->totalTicks += ticks * (int64_t)UserTick;
+	    stats->userTicks += ticks * (int64_t)UserTick;
     }
     
     DEBUG('i', "\n== Tick %d ==\n", stats->totalTicks);
 
+// nothing can fire before nextDue, so don't even look at the heap
+    if (stats->totalTicks < nextDue)
+	return;
+
 // check any pending interrupts are now ready to fire
     
     
@@ -222,19 +243,41 @@ Interrupt::Idle()
 {
     DEBUG('i', "Machine idling; checking for interrupts.\n");
     status = IdleMode;
-    if (CheckIfDue(TRUE)) {		// check for any pending interrupts
-    	while (CheckIfDue(FALSE))	// check for any other pending 
-	    ;				// interrupts
-        yieldOnReturn = FALSE;		// since there's nothing in the
+
+    // While idle we wait on the host files directly, instead of jumping
+    // ahead from one periodic host poll to the next.
+    Cancel(hostPoll);
+
+    for (;;) {
+	PollWatchedFiles(FALSE);	// pick up any host input that has
+					// already arrived
+	if (numPending > 0 && pending[0]->type == NetworkTimerInt)
+	    PollWatchedFiles(TRUE, NetworkTimerHostWait);
+					// give the other machines a chance
+					// to answer before the timer fires
+	if (CheckIfDue(TRUE)) {		// check for any pending interrupts
+	    while (CheckIfDue(FALSE))	// check for any other pending 
+		;			// interrupts
+	    yieldOnReturn = FALSE;	// since there's nothing in the
 					// ready queue, the yield is automatic
-        status = SystemMode;
-	return;				// return in case there's now
+	    status = SystemMode;
+	    StartHostPoll();
+	    return;			// return in case there's now
 					// a runnable thread
+	}
+	if (NumWatchedFiles() == 0)
+	    break;
+
+	// Nothing will happen until the console or the network gets
+	// input from the host, so sleep until it does.  The device
+	// schedules its interrupt, and we go around again.
+	DEBUG('i', "Machine idle.  Waiting for host input.\n");
+	PollWatchedFiles(TRUE);
     }
 
     // if there are no pending interrupts, and nothing is on the ready
     // queue, it is time to stop.   If the console or the network is 
-    // operating, there are *always* pending interrupts, so this code
+    // operating, we wait for host input above instead, so this code
     // is not reached.  Instead, the halt must be invoked by the user program.
 
     DEBUG('i', "Machine idle.  No interrupts to do.\n");
@@ -243,6 +286,35 @@ Interrupt::Idle()
     Halt();
 }
 
+//----------------------------------------------------------------------
+// Interrupt::StartHostPoll, Interrupt::PollHostIO
+// 	While Nachos is busy, check the watched host files once every
+//	HostPollTime ticks, with one select for all the devices.  The
+//	devices only schedule their interrupts when data has arrived.
+//	(When Nachos is idle, Idle waits on the files instead.)
+//----------------------------------------------------------------------
+
+static void
+HostIOPoll(int arg)
+{
+    Interrupt *intr = (Interrupt *) arg;
+    intr->PollHostIO();
+}
+
+void
+Interrupt::StartHostPoll()
+{
+    if (!IsPending(hostPoll) && NumWatchedFiles() > 0)
+	hostPoll = Schedule(HostIOPoll, (int) this, HostPollTime, HostIOInt);
+}
+
+void
+Interrupt::PollHostIO()
+{
+    PollWatchedFiles(FALSE);
+    StartHostPoll();
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Halt
 // 	Shut down Nachos cleanly, printing out performance statistics.
@@ -260,7 +332,9 @@ Interrupt::Halt()
 // 	Arrange for the CPU to be interrupted when simulated time
 //	reaches "now + when".
 //
-//	Implementation: just put it on a sorted list.
+//	Implementation: put it on a binary heap ordered by due time, so
+//	that scheduling and cancelling are O(log n) and finding the next
+//	interrupt to fire is O(1).
 //
 //	NOTE: the Nachos kernel should not call this routine directly.
 //	Instead, it is only called by the hardware device simulators.
@@ -270,12 +344,22 @@ Interrupt::Halt()
 //	"fromNow" is how far in the future (in simulated time) the 
 //		 interrupt is to occur
 //	"type" is the hardware device that generated the interrupt
+//
+//	Returns a handle on the scheduled interrupt, for Cancel and
+//	IsPending.
 //----------------------------------------------------------------------
-void
+InterruptHandle
 Interrupt::Schedule(VoidFunctionPtr handler, int arg, int64_t fromNow, IntType type)
 {
     int64_t when = stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(handler, arg, when, type);
+    PendingInterrupt *toOccur = freeRecords;
+
+    if (toOccur == NULL)
+	toOccur = new PendingInterrupt(handler, arg, when, type);
+    else {
+	freeRecords = toOccur->nextFree;
+	*toOccur = PendingInterrupt(handler, arg, when, type);
+    }
 
     //DEBUG('i', "Scheduling interrupt handler the %s at time = %d\n", 
 	//				intTypeNames[type], when);
@@ -283,7 +367,124 @@ Interrupt::Schedule(VoidFunctionPtr handler, int arg, int64_t fromNow, IntType t
         cout << "Scheduling interrupt handler the " << intTypeNames[type] << " at time = " << hex << when << endl;
     ASSERT(fromNow > 0);
 
-    pending->SortedInsert(toOccur, when);
+    if (numPending == maxPending) {	// out of room, double the heap
+	PendingInterrupt **bigger = new PendingInterrupt *[maxPending * 2];
+	for (int i = 0; i < numPending; i++)
+	    bigger[i] = pending[i];
+	delete [] pending;
+	pending = bigger;
+	maxPending *= 2;
+    }
+    toOccur->order = numScheduled++;
+    PlaceAt(numPending++, toOccur);
+    SiftUp(toOccur->heapIndex);
+
+    if (when < nextDue)
+	nextDue = when;
+
+    InterruptHandle handle;
+    handle.which = toOccur;
+    handle.order = toOccur->order;
+    return handle;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Cancel
+// 	Take back an interrupt returned by Schedule, so that its handler
+//	is never called.  Does nothing if it has already fired or been
+//	cancelled.  Either way the handle is cleared.
+//----------------------------------------------------------------------
+void
+Interrupt::Cancel(InterruptHandle &handle)
+{
+    if (IsPending(handle)) {
+	RemoveAt(handle.which->heapIndex);
+	FreeRecord(handle.which);
+	nextDue = (numPending > 0) ? pending[0]->when : NoPendingInterrupt;
+    }
+    handle = InterruptHandle();
+}
+
+//----------------------------------------------------------------------
+// Interrupt::IsPending
+// 	Is the interrupt of a handle from Schedule still to fire?  Its
+//	record may since hold another interrupt, with a later "order".
+//----------------------------------------------------------------------
+bool
+Interrupt::IsPending(InterruptHandle handle)
+{
+    return handle.which != NULL && handle.which->order == handle.order
+	&& handle.which->heapIndex >= 0;
+}
+
+void
+Interrupt::FreeRecord(PendingInterrupt *p)
+{
+    p->nextFree = freeRecords;
+    freeRecords = p;
+}
+
+//----------------------------------------------------------------------
+// Pending heap helpers
+// 	pending[0] is always the next interrupt to fire; the children of
+//	pending[i] are pending[2i+1] and pending[2i+2].  Each element
+//	remembers its own index, so that Cancel can find it.
+//----------------------------------------------------------------------
+bool
+Interrupt::Earlier(PendingInterrupt *a, PendingInterrupt *b)
+{
+    return (a->when < b->when) || (a->when == b->when && a->order < b->order);
+}
+
+void
+Interrupt::PlaceAt(int index, PendingInterrupt *p)
+{
+    pending[index] = p;
+    p->heapIndex = index;
+}
+
+void
+Interrupt::SiftUp(int index)
+{
+    PendingInterrupt *p = pending[index];
+
+    while (index > 0 && Earlier(p, pending[(index - 1) / 2])) {
+	PlaceAt(index, pending[(index - 1) / 2]);
+	index = (index - 1) / 2;
+    }
+    PlaceAt(index, p);
+}
+
+void
+Interrupt::SiftDown(int index)
+{
+    PendingInterrupt *p = pending[index];
+
+    for (;;) {
+	int child = 2 * index + 1;
+	if (child >= numPending)
+	    break;
+	if (child + 1 < numPending && Earlier(pending[child + 1], pending[child]))
+	    child++;
+	if (!Earlier(pending[child], p))
+	    break;
+	PlaceAt(index, pending[child]);
+	index = child;
+    }
+    PlaceAt(index, p);
+}
+
+void
+Interrupt::RemoveAt(int index)
+{
+    PendingInterrupt *last = pending[--numPending];
+
+    pending[index]->heapIndex = -1;
+    if (index < numPending) {	// move the last element into the hole
+	PlaceAt(index, last);
+	SiftUp(index);
+	SiftDown(last->heapIndex);
+    }
 }
 
 //----------------------------------------------------------------------
@@ -314,10 +515,12 @@ Interrupt::CheckIfDue(bool advanceClock)
     if (DebugIsEnabled('i'))
 	    DumpState();
     
-    PendingInterrupt *toOccur = (PendingInterrupt *)pending->SortedRemove(&when);
-
-    if (toOccur == NULL)		// no pending interrupts
+    if (numPending == 0) {		// no pending interrupts
+	nextDue = NoPendingInterrupt;
 	return FALSE;			
+    }
+    PendingInterrupt *toOccur = pending[0];
+    when = toOccur->when;
 
     if (advanceClock ) 
     {	// advance the clock
@@ -327,18 +530,21 @@ Interrupt::CheckIfDue(bool advanceClock)
 	        stats->totalTicks = when;
         }
     } else if (when > stats->totalTicks) 
-    {	// not time yet, put it back
-	    pending->SortedInsert(toOccur, when);
+    {	// not time yet, leave it where it is
+	    nextDue = when;		// it is the earliest one
 	    return FALSE;
     }
 
 // Check if there is nothing more to do, and if so, quit
     if ((status == IdleMode) && (toOccur->type == TimerInt) 
-				&& pending->IsEmpty()) {
-	 pending->SortedInsert(toOccur, when);
+				&& numPending == 1) {
+	 nextDue = when;
 	 return FALSE;
     }
 
+    RemoveAt(0);
+    nextDue = (numPending > 0) ? pending[0]->when : NoPendingInterrupt;
+
     //DEBUG('i', "Invoking interrupt handler for the %s at time %d\n", 
 	//		intTypeNames[toOccur->type], toOccur->when);
     if(DebugIsEnabled('i'))
@@ -354,7 +560,7 @@ Interrupt::CheckIfDue(bool advanceClock)
     (*(toOccur->handler))(toOccur->arg);	// call the interrupt handler
     status = old;				// restore the machine status
     inHandler = FALSE;
-    delete toOccur;
+    FreeRecord(toOccur);
     return TRUE;
 }
 
@@ -386,7 +592,8 @@ Interrupt::DumpState()
     //printf("Time: %d, interrupts %s\n", stats->totalTicks, intLevelNames[level]);
     printf("Pending interrupts:\n");
     fflush(stdout);
-    pending->Mapcar(PrintPending);
+    for (int i = 0; i < numPending; i++)	// in heap order, not time order
+	PrintPending((int) pending[i]);
     printf("End of pending interrupts\n");
     fflush(stdout);
 }
@@ -37,6 +37,7 @@
 
 #include "copyright.h"
 #include "list.h"
+#include "utility.h"
 
 // Interrupts can be disabled (IntOff) or enabled (IntOn)
 enum IntStatus { IntOff, IntOn };
@@ -50,7 +51,14 @@ enum MachineStatus {IdleMode, SystemMode, UserMode};
 // In Nachos, we support a hardware timer device, a disk, a console
 // display and keyboard, and a network.
 enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt, 
-				NetworkSendInt, NetworkRecvInt};
+				NetworkSendInt, NetworkRecvInt, HostIOInt,
+				NetworkTimerInt, AlarmInt};
+
+// A NetworkTimerInt (eg, a retransmission timer) stands for time passing
+// on the other machines too, so when Nachos is idle it first waits this
+// many microseconds of host time for network input, instead of jumping
+// straight ahead to the timer.
+#define NetworkTimerHostWait	50000
 
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
@@ -67,6 +75,23 @@ class PendingInterrupt {
     int arg;                    // The argument to the function.
     int64_t when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+
+    int64_t order;		// interrupts due at the same time fire in
+				// the order they were scheduled
+    int heapIndex;		// where we are in the pending heap, or
+				// -1 once we have fired or been cancelled
+    PendingInterrupt *nextFree;	// next in the pool of unused records
+};
+
+// What Schedule returns, to Cancel the interrupt with later.  Records
+// of interrupts that have fired or been cancelled are reused, never
+// freed, and "order" tells whether the record still holds the interrupt
+// the handle is for, so a handle can be used at any time.
+class InterruptHandle {
+  public:
+    InterruptHandle() { which = NULL; order = -1; }
+    PendingInterrupt *which;	// NULL if nothing was scheduled
+    int64_t order;		// the interrupt's "order"
 };
 
 // The following class defines the data structures for the simulation
@@ -74,6 +99,9 @@ class PendingInterrupt {
 // or disabled, and any hardware interrupts that are scheduled to occur
 // in the future.
 
+#define NoPendingInterrupt	((int64_t) 0x7fffffffffffffffLL)
+					// "nextDue" when nothing is pending
+
 class Interrupt {
   public:
     Interrupt();			// initialize the interrupt simulation
@@ -106,16 +134,35 @@ class Interrupt {
     // but they need to be public since they are called by the
     // hardware device simulators.
 
-    void Schedule(VoidFunctionPtr handler,// Schedule an interrupt to occur
-	int arg, int64_t when, IntType type);// at time ``when''.  This is called
-    					// by the hardware device simulators.
+    InterruptHandle Schedule(VoidFunctionPtr handler,// Schedule an interrupt
+	int arg, int64_t when, IntType type);// to occur at time ``when''.
+    					// This is called by the hardware
+					// device simulators.
+    void Cancel(InterruptHandle &handle);// Take back a scheduled interrupt,
+					// if it has not fired yet.
+    bool IsPending(InterruptHandle handle); // Has it neither fired nor
+					// been cancelled?
     
-    void OneTick();       		// Advance simulated time
+    void OneTick(int ticks = 1);	// Advance simulated time
+
+    void StartHostPoll();		// Make sure the host files that the
+    void PollHostIO();			// devices read from get checked
+					// (see WatchFile in sysdep.h)
 
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    List *pending;		// the list of interrupts scheduled
-				// to occur in the future
+    PendingInterrupt **pending;	// binary min-heap (by when, then order)
+				// of the interrupts scheduled to occur
+				// in the future
+    int numPending;		// number of interrupts in the heap
+    int maxPending;		// size of the "pending" array
+    int64_t numScheduled;	// gives each new interrupt its "order"
+    InterruptHandle hostPoll;	// next check of the watched host files
+				// while we are busy
+    PendingInterrupt *freeRecords; // pool of unused interrupt records
+    int64_t nextDue;		// no pending interrupt is due before this
+				// time, so OneTick need not look at
+				// "pending" until totalTicks reaches it
     bool inHandler;		// TRUE if we are running an interrupt handler
     bool yieldOnReturn; 	// TRUE if we are to context switch
 				// on return from the interrupt handler
@@ -126,6 +173,13 @@ class Interrupt {
     bool CheckIfDue(bool advanceClock); // Check if an interrupt is supposed
 					// to occur now
 
+    void FreeRecord(PendingInterrupt *p); // back to "freeRecords"
+    bool Earlier(PendingInterrupt *a, PendingInterrupt *b);
+    void PlaceAt(int index, PendingInterrupt *p);
+    void SiftUp(int index);		// restore heap order after an
+    void SiftDown(int index);		// element moved up or down
+    void RemoveAt(int index);		// take an element out of the heap
+
     void ChangeLevel(IntStatus old, 	// SetLevel, without advancing the
 	IntStatus now);  		// simulated time
 };
@@ -66,6 +66,7 @@ Machine::Machine(bool debug)
     for(i=0; i< NumPhysPages; i++)
     {
       lastUsed[i] = stats->totalTicks;
+      InvalidateDecodedFrame(i);
     }
 
 #ifdef USE_TLB
@@ -78,6 +79,7 @@ Machine::Machine(bool debug)
     pageTable = NULL;
 #endif
 
+    FlushTranslationCache();
     singleStep = debug;
     CheckEndian();
 }
@@ -96,6 +98,38 @@ int Machine::getTimeUsed(int pageNo)
 
 }
 
+//----------------------------------------------------------------------
+// Machine::InvalidateDecodedFrame
+// 	Throw away any decoded instructions cached for physical page "ppn".
+//	Must be called whenever the kernel changes the contents of a frame
+//	without going through WriteMem (eg, paging it in from disk).
+//----------------------------------------------------------------------
+
+void
+Machine::InvalidateDecodedFrame(int ppn)
+{
+    ASSERT(ppn >= 0 && ppn < NumPhysPages);
+    for (int i = 0; i < PageSize / 4; i++)
+	decodeValid[ppn * (PageSize / 4) + i] = FALSE;
+    InvalidateBlocks(ppn);
+}
+
+//----------------------------------------------------------------------
+// Machine::InvalidateBlocks
+// 	Throw away the translated blocks that start in physical page "ppn".
+//	A block that is running right now keeps its BlockOps, since they
+//	are only overwritten when a new block is built at the same word.
+//----------------------------------------------------------------------
+
+void
+Machine::InvalidateBlocks(int ppn)
+{
+    ASSERT(ppn >= 0 && ppn < NumPhysPages);
+    for (int i = 0; i < PageSize / 4; i++)
+	blockLength[ppn * (PageSize / 4) + i] = 0;
+    frameHasBlocks[ppn] = FALSE;
+}
+
 //----------------------------------------------------------------------
 // Machine::~Machine
 // 	De-allocate the data structures used to simulate user program execution.
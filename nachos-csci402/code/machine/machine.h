@@ -93,6 +93,25 @@ class Instruction {
                      // Immediates are sign-extended.
 };
 
+// The threaded-code engine (see Machine::RunBlock) translates a run of
+// straight-line instructions into a block of BlockOps: each one is the
+// decoded instruction, pre-bound to the routine that executes it.  The
+// block ends after a branch or jump (and its delay slot), a syscall,
+// the end of the physical page, or MaxBlockLength instructions.
+
+#define MaxBlockLength	16
+
+#define NoCachedVPN	((unsigned int) -1)	// never a valid page number
+
+class Machine;
+typedef bool (*BlockHandler)(Machine *m, Instruction *instr);
+				// returns FALSE if the instruction trapped
+
+struct BlockOp {
+    BlockHandler handler;	// routine that executes "instr"
+    Instruction *instr;		// decoded instruction, in the decode cache
+};
+
 // The following class defines the simulated host workstation hardware, as 
 // seen by user programs -- the CPU registers, main memory, etc.
 // User programs shouldn't be able to tell that they are running on our 
@@ -125,6 +144,13 @@ class Machine {
 
     void OneInstruction(Instruction *instr); 	
     				// Run one instruction of a user program.
+    bool ExecuteInstruction(Instruction *instr);
+				// Carry out an already decoded instruction;
+				// FALSE if it trapped to the kernel.
+    Instruction *DecodedInstruction(int physAddr);
+				// Decoded instruction at a physical address
+    void RunBlock(Instruction *instr);
+				// Run one translated block of a user program
     void DelayedLoad(int nextReg, int nextVal);  	
 				// Do a pending delayed load (modifying a reg)
     
@@ -186,12 +212,44 @@ class Machine {
 
    int getTimeUsed( int pageNo );
 
+    void InvalidateDecodedFrame(int ppn);
+				// Forget the pre-decoded instructions for
+				// physical page "ppn", because the kernel
+				// has loaded new contents into it.
+    void InvalidateBlocks(int ppn);
+				// Forget the translated blocks in physical
+				// page "ppn", because it was written to.
+    void FlushTranslationCache();
+				// Forget the cached translations used by
+				// Translate's fast path; call whenever the
+				// TLB or page table is modified.
+
   private:
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
     int64_t runUntilTime;		// drop back into the debugger when simulated
 				// time reaches this value
     int64_t lastUsed[NumPhysPages]; //This is the time stamp of when the page was last used.
+
+    // Decoded instruction cache, one slot per word of physical memory.
+    // OneInstruction only fetches and decodes a word when its slot is
+    // not valid; any write to the word clears the slot again.
+    Instruction decodeCache[MemorySize / 4];
+    bool decodeValid[MemorySize / 4];
+
+    // Translated blocks, indexed by the physical word they start at.
+    // Blocks never cross a page boundary, so a frame's blocks can be
+    // thrown away together when the frame changes.
+    int BuildBlock(int physAddr);
+    BlockOp blockCache[MemorySize / 4][MaxBlockLength];
+    int blockLength[MemorySize / 4];	// 0 if no block starts here
+    bool frameHasBlocks[NumPhysPages];
+
+    // Host-only cache of the last successful read and write translation,
+    // so that Translate can skip the TLB/page table on the common case of
+    // another access to the same page.  NoCachedVPN means empty.
+    unsigned int lastReadVPN, lastWriteVPN;
+    unsigned int lastReadBase, lastWriteBase;	// physical address of frame
 };
 
 extern void ExceptionHandler(ExceptionType which);
@@ -35,11 +35,17 @@ Machine::Run()
     if(DebugIsEnabled('m'))
         cout << "Starting thread \"" << currentThread->getName() << "\" at time " << hex << stats->totalTicks << endl;
     interrupt->setStatus(UserMode);
+    if (useBlockEngine && !singleStep && !DebugIsEnabled('m')) {
+	for (;;)
+	    RunBlock(instr);
+    }
     for (;;) {
         OneInstruction(instr);
 	interrupt->OneTick();
+#ifndef NO_TRACE
 	if (singleStep && (runUntilTime <= stats->totalTicks))
 	  Debugger();
+#endif
     }
 }
 
@@ -93,15 +99,26 @@ void
 Machine::OneInstruction(Instruction *instr)
 {
     int raw;
-    int nextLoadReg = 0;
-    int nextLoadValue = 0; 	// record delayed load operation, to apply
-				// in the future
 
     // Fetch instruction
-    if (!machine->ReadMem(registers[PCReg], 4, &raw))
-	return;			// exception occurred
-    instr->value = raw;
-    instr->Decode();
+    if (useDecodeCache) {
+	// Translate the PC ourselves, so that we can use the decoded
+	// copy of the instruction if this word has been executed before.
+	int physAddr;
+	ExceptionType exception = Translate(registers[PCReg], &physAddr, 4, FALSE);
+
+	if (exception != NoException) {
+	    RaiseException(exception, registers[PCReg]);
+	    return;
+	}
+	lastUsed[(unsigned) physAddr / PageSize] = stats->totalTicks;
+	instr = DecodedInstruction(physAddr);
+    } else {
+	if (!machine->ReadMem(registers[PCReg], 4, &raw))
+	    return;			// exception occurred
+	instr->value = raw;
+	instr->Decode();
+    }
 
     if (DebugIsEnabled('m')) {
       struct OpString *str = &opStrings[(int)instr->opCode];
@@ -113,6 +130,46 @@ Machine::OneInstruction(Instruction *instr)
       printf("\n");
     }
 
+    ExecuteInstruction(instr);
+}
+
+//----------------------------------------------------------------------
+// Machine::DecodedInstruction
+// 	Return the decoded form of the instruction stored at physical
+//	address "physAddr", decoding it only if the word has been
+//	written (or paged in) since it was last decoded.
+//----------------------------------------------------------------------
+
+Instruction *
+Machine::DecodedInstruction(int physAddr)
+{
+    int slot = (unsigned) physAddr / 4;
+
+    if (!decodeValid[slot]) {
+	decodeCache[slot].value =
+	    WordToHost(*(unsigned int *) &mainMemory[physAddr]);
+	decodeCache[slot].Decode();
+	decodeValid[slot] = TRUE;
+    }
+    return &decodeCache[slot];
+}
+
+//----------------------------------------------------------------------
+// Machine::ExecuteInstruction
+// 	Carry out one already decoded instruction, including any delayed
+//	load and the update of the program counters.
+//
+//	Returns FALSE if the instruction trapped to the kernel instead of
+//	completing (the kernel has already been run by RaiseException).
+//----------------------------------------------------------------------
+
+bool
+Machine::ExecuteInstruction(Instruction *instr)
+{
+    int nextLoadReg = 0;
+    int nextLoadValue = 0; 	// record delayed load operation, to apply
+				// in the future
+
     // Compute next pc, but don't install in case there's an error or branch.
     int pcAfter = registers[NextPCReg] + 4;
     int sum, diff, tmp, value;
@@ -126,7 +183,7 @@ Machine::OneInstruction(Instruction *instr)
 	if (!((registers[(int)instr->rs] ^ registers[(int)instr->rt]) & SIGN_BIT) &&
 	    ((registers[(int)instr->rs] ^ sum) & SIGN_BIT)) {
 	    RaiseException(OverflowException, 0);
-	    return;
+	    return FALSE;
 	}
 	registers[(int)instr->rd] = sum;
 	break;
@@ -136,7 +193,7 @@ Machine::OneInstruction(Instruction *instr)
 	if (!((registers[(int)instr->rs] ^ instr->extra) & SIGN_BIT) &&
 	    ((instr->extra ^ sum) & SIGN_BIT)) {
 	    RaiseException(OverflowException, 0);
-	    return;
+	    return FALSE;
 	}
 	registers[(int)instr->rt] = sum;
 	break;
@@ -231,7 +288,7 @@ Machine::OneInstruction(Instruction *instr)
       case OP_LBU:
 	tmp = registers[(int)instr->rs] + instr->extra;
 	if (!machine->ReadMem(tmp, 1, &value))
-	    return;
+	    return FALSE;
 
 	if ((value & 0x80) && (instr->opCode == OP_LB))
 	    value |= 0xffffff00;
@@ -246,10 +303,10 @@ Machine::OneInstruction(Instruction *instr)
 	tmp = registers[(int)instr->rs] + instr->extra;
 	if (tmp & 0x1) {
 	    RaiseException(AddressErrorException, tmp);
-	    return;
+	    return FALSE;
 	}
 	if (!machine->ReadMem(tmp, 2, &value))
-	    return;
+	    return FALSE;
 
 	if ((value & 0x8000) && (instr->opCode == OP_LH))
 	    value |= 0xffff0000;
@@ -268,10 +325,10 @@ Machine::OneInstruction(Instruction *instr)
 	tmp = registers[(int)instr->rs] + instr->extra;
 	if (tmp & 0x3) {
 	    RaiseException(AddressErrorException, tmp);
-	    return;
+	    return FALSE;
 	}
 	if (!machine->ReadMem(tmp, 4, &value))
-	    return;
+	    return FALSE;
 	nextLoadReg = instr->rt;
 	nextLoadValue = value;
 	break;
@@ -285,7 +342,7 @@ Machine::OneInstruction(Instruction *instr)
 	ASSERT((tmp & 0x3) == 0);
 
 	if (!machine->ReadMem(tmp, 4, &value))
-	    return;
+	    return FALSE;
 	if (registers[LoadReg] == instr->rt)
 	    nextLoadValue = registers[LoadValueReg];
 	else
@@ -316,7 +373,7 @@ Machine::OneInstruction(Instruction *instr)
 	ASSERT((tmp & 0x3) == 0);
 
 	if (!machine->ReadMem(tmp, 4, &value))
-	    return;
+	    return FALSE;
 	if (registers[LoadReg] == instr->rt)
 	    nextLoadValue = registers[LoadValueReg];
 	else
@@ -382,13 +439,13 @@ Machine::OneInstruction(Instruction *instr)
       case OP_SB:
 	if (!machine->WriteMem((unsigned)
 		(registers[(int)instr->rs] + instr->extra), 1, registers[(int)instr->rt]))
-	    return;
+	    return FALSE;
 	break;
 
       case OP_SH:
 	if (!machine->WriteMem((unsigned)
 		(registers[(int)instr->rs] + instr->extra), 2, registers[(int)instr->rt]))
-	    return;
+	    return FALSE;
 	break;
 
       case OP_SLL:
@@ -458,7 +515,7 @@ Machine::OneInstruction(Instruction *instr)
 	if (((registers[(int)instr->rs] ^ registers[(int)instr->rt]) & SIGN_BIT) &&
 	    ((registers[(int)instr->rs] ^ diff) & SIGN_BIT)) {
 	    RaiseException(OverflowException, 0);
-	    return;
+	    return FALSE;
 	}
 	registers[(int)instr->rd] = diff;
 	break;
@@ -470,7 +527,7 @@ Machine::OneInstruction(Instruction *instr)
       case OP_SW:
 	if (!machine->WriteMem((unsigned)
 		(registers[(int)instr->rs] + instr->extra), 4, registers[(int)instr->rt]))
-	    return;
+	    return FALSE;
 	break;
 
       case OP_SWL:
@@ -481,7 +538,7 @@ Machine::OneInstruction(Instruction *instr)
 	ASSERT((tmp & 0x3) == 0);
 
 	if (!machine->ReadMem((tmp & ~0x3), 4, &value))
-	    return;
+	    return FALSE;
 	switch (tmp & 0x3) {
 	  case 0:
 	    value = registers[(int)instr->rt];
@@ -500,7 +557,7 @@ Machine::OneInstruction(Instruction *instr)
 	    break;
 	}
 	if (!machine->WriteMem((tmp & ~0x3), 4, value))
-	    return;
+	    return FALSE;
 	break;
 
       case OP_SWR:
@@ -511,7 +568,7 @@ Machine::OneInstruction(Instruction *instr)
 	ASSERT((tmp & 0x3) == 0);
 
 	if (!machine->ReadMem((tmp & ~0x3), 4, &value))
-	    return;
+	    return FALSE;
 	switch (tmp & 0x3) {
 	  case 0:
 	    value = (value & 0xffffff) | (registers[(int)instr->rt] << 24);
@@ -527,12 +584,12 @@ Machine::OneInstruction(Instruction *instr)
 	    break;
 	}
 	if (!machine->WriteMem((tmp & ~0x3), 4, value))
-	    return;
+	    return FALSE;
 	break;
 
       case OP_SYSCALL:
 	RaiseException(SyscallException, 0);
-	return;
+	return FALSE;
 
       case OP_XOR:
 	registers[(int)instr->rd] = registers[(int)instr->rs] ^ registers[(int)instr->rt];
@@ -545,7 +602,7 @@ Machine::OneInstruction(Instruction *instr)
       case OP_RES:
       case OP_UNIMP:
 	RaiseException(IllegalInstrException, 0);
-	return;
+	return FALSE;
 
       default:
 	ASSERT(FALSE);
@@ -561,6 +618,390 @@ Machine::OneInstruction(Instruction *instr)
 						// are jumping into lala-land
     registers[PCReg] = registers[NextPCReg];
     registers[NextPCReg] = pcAfter;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Threaded-code handlers
+// 	Each handler executes one kind of instruction, exactly as the
+//	matching case of ExecuteInstruction does, and then finishes the
+//	instruction with FinishInstruction.  Instructions without a
+//	handler of their own use ExecuteGeneric.
+//
+//	The handlers return FALSE if the instruction trapped to the kernel.
+//----------------------------------------------------------------------
+
+static inline void
+FinishInstruction(Machine *m, int nextLoadReg, int nextLoadValue, int pcAfter)
+{
+    m->DelayedLoad(nextLoadReg, nextLoadValue);
+    m->registers[PrevPCReg] = m->registers[PCReg];
+    m->registers[PCReg] = m->registers[NextPCReg];
+    m->registers[NextPCReg] = pcAfter;
+}
+
+static bool
+ExecuteGeneric(Machine *m, Instruction *instr)
+{
+    return m->ExecuteInstruction(instr);
+}
+
+static bool
+ExecuteADDIU(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[(int)instr->rt] = r[(int)instr->rs] + instr->extra;
+    FinishInstruction(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecuteADDU(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[(int)instr->rd] = r[(int)instr->rs] + r[(int)instr->rt];
+    FinishInstruction(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecuteSUBU(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[(int)instr->rd] = r[(int)instr->rs] - r[(int)instr->rt];
+    FinishInstruction(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecuteAND(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[(int)instr->rd] = r[(int)instr->rs] & r[(int)instr->rt];
+    FinishInstruction(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecuteANDI(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[(int)instr->rt] = r[(int)instr->rs] & (instr->extra & 0xffff);
+    FinishInstruction(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecuteORI(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[(int)instr->rt] = r[(int)instr->rs] | (instr->extra & 0xffff);
+    FinishInstruction(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecuteLUI(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[(int)instr->rt] = instr->extra << 16;
+    FinishInstruction(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecuteSLL(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[(int)instr->rd] = r[(int)instr->rt] << instr->extra;
+    FinishInstruction(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecuteSRA(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[(int)instr->rd] = r[(int)instr->rt] >> instr->extra;
+    FinishInstruction(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecuteSLT(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[(int)instr->rd] = (r[(int)instr->rs] < r[(int)instr->rt]) ? 1 : 0;
+    FinishInstruction(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecuteSLTI(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[(int)instr->rt] = (r[(int)instr->rs] < instr->extra) ? 1 : 0;
+    FinishInstruction(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecuteSLTU(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[(int)instr->rd] =
+	((unsigned) r[(int)instr->rs] < (unsigned) r[(int)instr->rt]) ? 1 : 0;
+    FinishInstruction(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecuteSLTIU(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[(int)instr->rt] =
+	((unsigned) r[(int)instr->rs] < (unsigned) instr->extra) ? 1 : 0;
+    FinishInstruction(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecuteLW(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+    int addr = r[(int)instr->rs] + instr->extra;
+    int value;
+
+    if (addr & 0x3) {
+	m->RaiseException(AddressErrorException, addr);
+	return FALSE;
+    }
+    if (!m->ReadMem(addr, 4, &value))
+	return FALSE;
+    FinishInstruction(m, instr->rt, value, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecuteSW(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    if (!m->WriteMem((unsigned) (r[(int)instr->rs] + instr->extra), 4,
+		     r[(int)instr->rt]))
+	return FALSE;
+    FinishInstruction(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecuteBEQ(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+    int pcAfter = r[NextPCReg] + 4;
+
+    if (r[(int)instr->rs] == r[(int)instr->rt])
+	pcAfter = r[NextPCReg] + IndexToAddr(instr->extra);
+    FinishInstruction(m, 0, 0, pcAfter);
+    return TRUE;
+}
+
+static bool
+ExecuteBNE(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+    int pcAfter = r[NextPCReg] + 4;
+
+    if (r[(int)instr->rs] != r[(int)instr->rt])
+	pcAfter = r[NextPCReg] + IndexToAddr(instr->extra);
+    FinishInstruction(m, 0, 0, pcAfter);
+    return TRUE;
+}
+
+static bool
+ExecuteJ(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+    int pcAfter = r[NextPCReg] + 4;
+
+    FinishInstruction(m, 0, 0,
+		      (pcAfter & 0xf0000000) | IndexToAddr(instr->extra));
+    return TRUE;
+}
+
+static bool
+ExecuteJAL(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+    int pcAfter = r[NextPCReg] + 4;
+
+    r[R31] = r[NextPCReg] + 4;
+    FinishInstruction(m, 0, 0,
+		      (pcAfter & 0xf0000000) | IndexToAddr(instr->extra));
+    return TRUE;
+}
+
+static bool
+ExecuteJR(Machine *m, Instruction *instr)
+{
+    FinishInstruction(m, 0, 0, m->registers[(int)instr->rs]);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// HandlerFor
+// 	Pick the threaded-code handler for a decoded opcode.
+//----------------------------------------------------------------------
+
+static BlockHandler
+HandlerFor(int opCode)
+{
+    switch (opCode) {
+      case OP_ADDIU:	return ExecuteADDIU;
+      case OP_ADDU:	return ExecuteADDU;
+      case OP_SUBU:	return ExecuteSUBU;
+      case OP_AND:	return ExecuteAND;
+      case OP_ANDI:	return ExecuteANDI;
+      case OP_ORI:	return ExecuteORI;
+      case OP_LUI:	return ExecuteLUI;
+      case OP_SLL:	return ExecuteSLL;
+      case OP_SRA:	return ExecuteSRA;
+      case OP_SLT:	return ExecuteSLT;
+      case OP_SLTI:	return ExecuteSLTI;
+      case OP_SLTU:	return ExecuteSLTU;
+      case OP_SLTIU:	return ExecuteSLTIU;
+      case OP_LW:	return ExecuteLW;
+      case OP_SW:	return ExecuteSW;
+      case OP_BEQ:	return ExecuteBEQ;
+      case OP_BNE:	return ExecuteBNE;
+      case OP_J:	return ExecuteJ;
+      case OP_JAL:	return ExecuteJAL;
+      case OP_JR:	return ExecuteJR;
+      default:		return ExecuteGeneric;
+    }
+}
+
+//----------------------------------------------------------------------
+// EndsBlock
+// 	TRUE if the instruction may change the flow of control, so the
+//	block has to end after it (and its delay slot, for a branch).
+//----------------------------------------------------------------------
+
+static bool
+EndsBlock(int opCode)
+{
+    switch (opCode) {
+      case OP_BEQ: case OP_BNE: case OP_BGEZ: case OP_BGEZAL:
+      case OP_BGTZ: case OP_BLEZ: case OP_BLTZ: case OP_BLTZAL:
+      case OP_J: case OP_JAL: case OP_JR: case OP_JALR:
+      case OP_SYSCALL: case OP_RES: case OP_UNIMP:
+	return TRUE;
+      default:
+	return FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::BuildBlock
+// 	Translate the straight-line run of instructions starting at
+//	physical address "physAddr" into a block of BlockOps, and return
+//	the number of instructions in it.
+//----------------------------------------------------------------------
+
+int
+Machine::BuildBlock(int physAddr)
+{
+    int start = (unsigned) physAddr / 4;
+    int pageEnd = ((unsigned) physAddr / PageSize + 1) * (PageSize / 4);
+    BlockOp *ops = blockCache[start];
+    int length = 0;
+
+    for (int slot = start; slot < pageEnd && length < MaxBlockLength; slot++) {
+	Instruction *instr = DecodedInstruction(slot * 4);
+
+	ops[length].handler = HandlerFor(instr->opCode);
+	ops[length].instr = instr;
+	length++;
+	if (EndsBlock(instr->opCode)) {
+	    // the delay slot runs before a branch takes effect, so keep
+	    // it in the same block if it is in the same page
+	    if (instr->opCode != OP_SYSCALL && slot + 1 < pageEnd &&
+		length < MaxBlockLength) {
+		instr = DecodedInstruction((slot + 1) * 4);
+		ops[length].handler = HandlerFor(instr->opCode);
+		ops[length].instr = instr;
+		length++;
+	    }
+	    break;
+	}
+    }
+    blockLength[start] = length;
+    frameHasBlocks[(unsigned) physAddr / PageSize] = TRUE;
+    return length;
+}
+
+//----------------------------------------------------------------------
+// Machine::RunBlock
+// 	Run one translated block of a user program, and then charge one
+//	UserTick per instruction executed, in a single call to OneTick.
+//	This is the threaded-code replacement for calling OneInstruction
+//	and OneTick once per instruction.
+//
+//	Pending interrupts are only checked between blocks, so a device
+//	interrupt may be taken up to MaxBlockLength ticks later than the
+//	reference interpreter would take it.
+//
+//	"instr" is scratch space for OneInstruction, which we fall back on
+//	when the PC is in a branch delay slot (a block assumes that the
+//	PCs advance in a straight line).
+//----------------------------------------------------------------------
+
+void
+Machine::RunBlock(Instruction *instr)
+{
+    int physAddr;
+
+    if (registers[NextPCReg] != registers[PCReg] + 4) {
+	OneInstruction(instr);
+	interrupt->OneTick();
+	return;
+    }
+
+    ExceptionType exception = Translate(registers[PCReg], &physAddr, 4, FALSE);
+    if (exception != NoException) {
+	RaiseException(exception, registers[PCReg]);
+	interrupt->OneTick();
+	return;
+    }
+    lastUsed[(unsigned) physAddr / PageSize] = stats->totalTicks;
+
+    int start = (unsigned) physAddr / 4;
+    int length = blockLength[start];
+    if (length == 0)
+	length = BuildBlock(physAddr);
+
+    // run the block; stop early if an instruction traps to the kernel
+    BlockOp *ops = blockCache[start];
+    int executed = 0;
+    while (executed < length) {
+	BlockOp *op = &ops[executed++];
+	if (!(*op->handler)(this, op->instr))
+	    break;
+    }
+    interrupt->OneTick(executed);
 }
 
 //----------------------------------------------------------------------
@@ -20,6 +20,8 @@ static void NetworkReadPoll(int arg)
 { Network *net = (Network *)arg; net->CheckPktAvail(); }
 static void NetworkSendDone(int arg)
 { Network *net = (Network *)arg; net->SendDone(); }
+static void NetworkDataReady(int arg)
+{ Network *net = (Network *)arg; net->DataReady(); }
 
 // Initialize the network emulation
 //   addr is used to generate the socket name
@@ -39,30 +41,44 @@ Network::Network(NetworkAddress addr, double reliability,
     handlerArg = callArg;
     sendBusy = FALSE;
     inHdr.length = 0;
+    readScheduled = FALSE;
     
     sock = OpenSocket();
     sprintf(sockName, "SOCKET_%d", (int)addr);
     AssignNameToSocket(sockName, sock);		 // Bind socket to a filename 
 						 // in the current directory.
 
-    // start polling for incoming packets
-    interrupt->Schedule(NetworkReadPoll, (int)this, NetworkTime, NetworkRecvInt);
+    // have the host tell us when packets arrive
+    WatchFile(sock, NetworkDataReady, (int)this);
 }
 
 Network::~Network()
 {
+    UnwatchFile(sock);
     CloseSocket(sock);
     DeAssignNameToSocket(sockName);
 }
 
+// called by the host I/O multiplexer when the socket has a packet;
+// schedule the receive interrupt NetworkTime from now, unless one is
+// already on its way
+void
+Network::DataReady()
+{
+    if (readScheduled)
+	return;
+    readScheduled = TRUE;
+    interrupt->Schedule(NetworkReadPoll, (int)this, NetworkTime, NetworkRecvInt);
+}
+
 // if a packet is already buffered, we simply delay reading 
-// the incoming packet.  In real life, the incoming 
+// the incoming packet (the next host poll will bring us back, since
+// the socket is still readable).  In real life, the incoming 
 // packet might be dropped if we can't read it in time.
 void
 Network::CheckPktAvail()
 {
-    // schedule the next time to poll for a packet
-    interrupt->Schedule(NetworkReadPoll, (int)this, NetworkTime, NetworkRecvInt);
+    readScheduled = FALSE;
 
     if (inHdr.length != 0) 	// do nothing if packet is already buffered
 	    return;		
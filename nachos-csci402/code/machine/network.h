@@ -79,6 +79,7 @@ class Network {
     void SendDone();		// Interrupt handler, called when message is 
 				// sent
     void CheckPktAvail();	// Check if there is an incoming packet
+    void DataReady();		// the host socket has a packet for us
 
   private:
     NetworkAddress ident;	// This machine's network address
@@ -95,6 +96,8 @@ class Network {
     bool packetAvail;		// Packet has arrived, can be pulled off of
 				//   network
     PacketHeader inHdr;		// Information about arrived packet
+    bool readScheduled;		// Is a CheckPktAvail interrupt already
+				//   on its way?
     char inbox[MaxPacketSize];  // Data for arrived packet
 };
 
@@ -23,6 +23,85 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numRetransmissions = numDuplicatesDropped = numAcksSent = 0;
+    numDispatches = numPriorityBoosts = numPriorityDemotions = 0;
+    numSpaceSwitches = 0;
+    readyWaitTicks = maxReadyWaitTicks = 0;
+    hostStartTime = HostSeconds();
+    for (int i = 0; i < MaxSyscallTypes; i++) {
+	syscallNames[i] = NULL;
+	numSyscalls[i] = numSyscallsReturned[i] = 0;
+	syscallTicks[i] = maxSyscallTicks[i] = 0;
+	syscallHostTime[i] = 0;
+	for (int j = 0; j < NumLatencyBuckets; j++)
+	    syscallTickHistogram[i][j] = syscallHostHistogram[i][j] = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// LatencyBucket
+// 	Which histogram bucket "value" falls in: 0 for 0, i for
+//	[2^(i-1), 2^i), and the last bucket for anything bigger.
+//----------------------------------------------------------------------
+
+static int
+LatencyBucket(int64_t value)
+{
+    int bucket = 0;
+
+    while (value > 0 && bucket < NumLatencyBuckets - 1) {
+	value >>= 1;
+	bucket++;
+    }
+    return bucket;
+}
+
+//----------------------------------------------------------------------
+// Statistics::StartSyscall, Statistics::FinishSyscall
+// 	Count a syscall, and record how long it took (in simulated ticks
+//	and in host seconds) once it returns to the user program.
+//----------------------------------------------------------------------
+
+void
+Statistics::StartSyscall(int type, char *name)
+{
+    ASSERT(type >= 0 && type < MaxSyscallTypes);
+    syscallNames[type] = name;
+    numSyscalls[type]++;
+}
+
+void
+Statistics::FinishSyscall(int type, int64_t ticks, double hostSeconds)
+{
+    numSyscallsReturned[type]++;
+    syscallTicks[type] += ticks;
+    if (ticks > maxSyscallTicks[type])
+	maxSyscallTicks[type] = ticks;
+    syscallHostTime[type] += hostSeconds;
+    syscallTickHistogram[type][LatencyBucket(ticks)]++;
+    syscallHostHistogram[type][LatencyBucket((int64_t) (hostSeconds * 1e6))]++;
+}
+
+//----------------------------------------------------------------------
+// PrintHistogram
+// 	Print the non-empty buckets of a latency histogram on one line.
+//----------------------------------------------------------------------
+
+static void
+PrintHistogram(char *label, int *histogram)
+{
+    printf("    %s:", label);
+    for (int i = 0; i < NumLatencyBuckets; i++) {
+	if (histogram[i] == 0)
+	    continue;
+	if (i == 0)
+	    printf(" [0] %d", histogram[i]);
+	else if (i == NumLatencyBuckets - 1)
+	    printf(" [%d+] %d", 1 << (i - 1), histogram[i]);
+	else
+	    printf(" [%d,%d) %d", 1 << (i - 1), 1 << i, histogram[i]);
+    }
+    printf("\n");
 }
 
 //----------------------------------------------------------------------
@@ -41,6 +120,36 @@ Statistics::Print()
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
     printf("Paging: faults %d\n", numPageFaults);
-    printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
-	numPacketsSent);
+    printf("Network I/O: packets received %d, sent %d, retransmitted %d, "
+	"duplicates dropped %d, acks %d\n", numPacketsRecvd, numPacketsSent,
+	numRetransmissions, numDuplicatesDropped, numAcksSent);
+    cout << "Scheduling: dispatches " << numDispatches << ", ready wait avg "
+	<< (numDispatches > 0 ? readyWaitTicks / numDispatches : 0)
+	<< " max " << maxReadyWaitTicks << " ticks, boosts "
+	<< numPriorityBoosts << ", demotions " << numPriorityDemotions
+	<< ", address space switches " << numSpaceSwitches << endl;
+
+    for (int i = 0; i < MaxSyscallTypes; i++) {
+	if (numSyscalls[i] == 0)
+	    continue;
+	printf("Syscall %s: %d calls", syscallNames[i], numSyscalls[i]);
+	if (numSyscallsReturned[i] > 0) {
+	    cout << ", ticks avg " << syscallTicks[i] / numSyscallsReturned[i]
+		 << " max " << maxSyscallTicks[i];
+	    printf(", host avg %.1f us\n",
+		   syscallHostTime[i] * 1e6 / numSyscallsReturned[i]);
+	    PrintHistogram("ticks", syscallTickHistogram[i]);
+	    PrintHistogram("host us", syscallHostHistogram[i]);
+	} else
+	    printf("\n");
+    }
+
+    // user instructions simulated per second of host time
+    double hostSeconds = HostSeconds() - hostStartTime;
+    int64_t userInstructions = userTicks / UserTick;
+    cout << "Host: " << userInstructions << " user instructions in ";
+    printf("%.3f seconds", hostSeconds);
+    if (hostSeconds > 0)
+	printf(", %.0f instructions/second", userInstructions / hostSeconds);
+    printf("\n");
 }
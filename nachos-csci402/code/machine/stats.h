@@ -13,6 +13,13 @@
 
 #include "copyright.h"
 
+// Per-syscall statistics: how many calls, and histograms of how long
+// they took, in simulated ticks and in host microseconds.  Bucket 0 is
+// for 0, bucket i (i > 0) for [2^(i-1), 2^i), and the last bucket for
+// anything longer.
+#define MaxSyscallTypes		64
+#define NumLatencyBuckets	20
+
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
 // many user instructions executed, etc.
@@ -35,9 +42,39 @@ class Statistics {
     int numPageFaults;		// number of virtual memory page faults
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
+    int numRetransmissions;	// messages the post office sent again
+    int numDuplicatesDropped;	// messages it received twice, or out of order
+    int numAcksSent;		// packets sent only to acknowledge messages
+
+    int numDispatches;		// number of times a thread was taken off
+				// the ready list to run
+    int64_t readyWaitTicks;	// total time threads spent on the ready list
+    int64_t maxReadyWaitTicks;	// longest time any thread spent there
+    int numPriorityBoosts;	// MLFQ: times a thread moved up to level 0
+    int numPriorityDemotions;	// MLFQ: times a thread moved down a level
+    int numSpaceSwitches;	// context switches between threads of
+				// different address spaces
+
+    double hostStartTime;	// host wall clock time (seconds) when Nachos
+				// started, to report simulator speed
+
+    char *syscallNames[MaxSyscallTypes];	// NULL if never called
+    int numSyscalls[MaxSyscallTypes];	// calls of each syscall
+    int numSyscallsReturned[MaxSyscallTypes]; // calls that returned (not
+				// Exit or Halt), and so were timed
+    int64_t syscallTicks[MaxSyscallTypes];	// total and longest simulated
+    int64_t maxSyscallTicks[MaxSyscallTypes];	// time of the timed calls
+    double syscallHostTime[MaxSyscallTypes];	// total host seconds
+    int syscallTickHistogram[MaxSyscallTypes][NumLatencyBuckets];
+    int syscallHostHistogram[MaxSyscallTypes][NumLatencyBuckets];
 
     Statistics(); 		// initialize everything to zero
 
+    void StartSyscall(int type, char *name);	// a user program made
+						// syscall "type"
+    void FinishSyscall(int type, int64_t ticks, double hostSeconds);
+				// ... and it returned after this long
+
     void Print();		// print collected statistics
 };
 
@@ -56,5 +93,7 @@ class Statistics {
 #define ConsoleTime 	(int64_t)100LL	// time to read or write one character
 #define NetworkTime 	(int64_t)100LL   	// time to send or receive one packet
 #define TimerTicks 	(int64_t)100LL    	// (average) time between timer interrupts
+#define HostPollTime 	(int64_t)100LL    	// time between checks for host
+						// input, when not idle
 
 #endif // STATS_H
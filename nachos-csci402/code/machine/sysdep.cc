@@ -80,6 +80,108 @@ PollFile(int fd)
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// Host readiness multiplexer
+// 	The files the simulated devices read from (keyboard, network
+//	socket), each with the handler to call when it becomes readable.
+//----------------------------------------------------------------------
+
+#define MaxWatchedFiles 8
+
+static struct WatchedFile {
+    int fd;
+    VoidFunctionPtr handler;
+    int arg;
+} watched[MaxWatchedFiles];
+static int numWatched = 0;
+
+//----------------------------------------------------------------------
+// WatchFile
+// 	Start calling "handler(arg)" whenever "fd" has data to be read,
+//	and make sure the interrupt simulation is checking for it.
+//----------------------------------------------------------------------
+
+void
+WatchFile(int fd, VoidFunctionPtr handler, int arg)
+{
+    ASSERT(numWatched < MaxWatchedFiles);
+    watched[numWatched].fd = fd;
+    watched[numWatched].handler = handler;
+    watched[numWatched].arg = arg;
+    numWatched++;
+    interrupt->StartHostPoll();
+}
+
+//----------------------------------------------------------------------
+// UnwatchFile
+// 	Stop watching "fd", eg, because its device is being deleted.
+//----------------------------------------------------------------------
+
+void
+UnwatchFile(int fd)
+{
+    for (int i = 0; i < numWatched; i++)
+	if (watched[i].fd == fd) {
+	    watched[i] = watched[--numWatched];
+	    return;
+	}
+}
+
+int
+NumWatchedFiles()
+{
+    return numWatched;
+}
+
+//----------------------------------------------------------------------
+// PollWatchedFiles
+// 	Check all the watched files with a single select, and call the
+//	handler of each one that is readable.  Return TRUE if any were.
+//
+//	"wait" -- if TRUE, put the UNIX process to sleep until one of the
+//		files is readable, instead of returning right away.  Used
+//		when Nachos is idle, so an idle server costs no host CPU.
+//	"waitMicroseconds" -- if not -1, the longest to sleep
+//----------------------------------------------------------------------
+
+bool
+PollWatchedFiles(bool wait, int waitMicroseconds)
+{
+    fd_set readFds;
+    int maxFd = -1, retVal;
+    struct timeval pollTime;
+
+    FD_ZERO(&readFds);
+    for (int i = 0; i < numWatched; i++) {
+	FD_SET(watched[i].fd, &readFds);
+	if (watched[i].fd > maxFd)
+	    maxFd = watched[i].fd;
+    }
+    if (maxFd < 0)
+	return FALSE;
+
+    pollTime.tv_sec = 0;
+    pollTime.tv_usec = 0;
+    if (wait && waitMicroseconds >= 0) {
+	pollTime.tv_sec = waitMicroseconds / 1000000;
+	pollTime.tv_usec = waitMicroseconds % 1000000;
+    }
+    retVal = select(maxFd + 1, &readFds, NULL, NULL,
+		    (wait && waitMicroseconds < 0) ? NULL : &pollTime);
+    if (retVal <= 0)		// nothing ready, or interrupted by a signal
+	return FALSE;
+
+    // a handler may unwatch its file, so work from a copy of the table
+    struct WatchedFile ready[MaxWatchedFiles];
+    int numReady = 0;
+    for (int i = 0; i < numWatched; i++)
+	if (FD_ISSET(watched[i].fd, &readFds))
+	    ready[numReady++] = watched[i];
+    for (int i = 0; i < numReady; i++)
+	(*ready[i].handler)(ready[i].arg);
+    return TRUE;
+}
+
 //----------------------------------------------------------------------
 // OpenForWrite
 // 	Open a file for writing.  Create it if it doesn't exist; truncate it 
@@ -355,6 +457,20 @@ Delay(int seconds)
     (void) sleep((unsigned) seconds);
 }
 
+//----------------------------------------------------------------------
+// HostSeconds
+// 	Return the host's wall clock time, in seconds.
+//----------------------------------------------------------------------
+
+double
+HostSeconds()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
 //----------------------------------------------------------------------
 // Abort
 // 	Quit and drop core.
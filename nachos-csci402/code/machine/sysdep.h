@@ -17,6 +17,18 @@
 // If no characters in the file, return without waiting.
 extern bool PollFile(int fd);
 
+// Host readiness multiplexer: rather than each device polling its own
+// file on a timer, devices register their files here, and the interrupt
+// simulation checks all of them with one select.  "handler(arg)" is
+// called (with interrupts off) whenever "fd" has data to be read.
+extern void WatchFile(int fd, VoidFunctionPtr handler, int arg);
+extern void UnwatchFile(int fd);
+extern int NumWatchedFiles();
+extern bool PollWatchedFiles(bool wait, int waitMicroseconds = -1);
+						// if "wait", block until one
+						// of the files is readable (or
+						// for at most "waitMicroseconds")
+
 // File operations: open/read/write/lseek/close, and check for error
 // For simulating the disk and the console devices.
 extern int OpenForWrite(char *name);
@@ -43,6 +55,9 @@ extern void Abort();
 extern void Exit(int exitCode);
 extern void Delay(int seconds);
 
+// Host wall clock time, in seconds, for measuring how fast we simulate
+extern double HostSeconds();
+
 // Initialize system so that cleanUp routine is called when user hits ctl-C
 extern void CallOnUserAbort(VoidNoArgFunctionPtr cleanUp);
 
@@ -175,8 +175,13 @@ Machine::WriteMem(int addr, int size, int value)
       default: ASSERT(FALSE);
     }
 
+    // the word may hold an instruction we already decoded
+    machine->decodeValid[(unsigned) physicalAddress / 4] = FALSE;
+
     //Update the time value only if we succeed
     ppn = (unsigned) physicalAddress/ PageSize;
+    if (machine->frameHasBlocks[ppn])
+	machine->InvalidateBlocks(ppn);
     machine->lastUsed[ppn] = stats->totalTicks;
 
     return TRUE;
@@ -205,6 +210,19 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     TranslationEntry *entry;
     unsigned int pageFrame;
 
+    // Fast path: the same page as the last successful translation of
+    // this kind.  The TLB or page table entry has not changed since then
+    // (FlushTranslationCache is called whenever the kernel touches them),
+    // so its use and dirty bits are already set.
+    if ((virtAddr & (size - 1)) == 0) {
+	vpn = (unsigned) virtAddr / PageSize;
+	if (writing ? (vpn == lastWriteVPN) : (vpn == lastReadVPN)) {
+	    *physAddr = (writing ? lastWriteBase : lastReadBase) +
+			(unsigned) virtAddr % PageSize;
+	    return NoException;
+	}
+    }
+
     DEBUG('a', "\tTranslate 0x%x, %s: ", virtAddr, writing ? "write" : "read");
 
 // check for alignment errors
@@ -272,5 +290,27 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     *physAddr = pageFrame * PageSize + offset;
     ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
     DEBUG('a', "phys addr = 0x%x\n", *physAddr);
+
+    // remember the translation for the fast path
+    if (writing) {
+	lastWriteVPN = vpn;
+	lastWriteBase = pageFrame * PageSize;
+    } else {
+	lastReadVPN = vpn;
+	lastReadBase = pageFrame * PageSize;
+    }
     return NoException;
 }
+
+//----------------------------------------------------------------------
+// Machine::FlushTranslationCache
+// 	Forget the last read and write translations used by the fast path
+//	in Translate.  Must be called whenever the kernel changes the TLB
+//	or the page table, or switches address spaces.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushTranslationCache()
+{
+    lastReadVPN = lastWriteVPN = NoCachedVPN;
+}
@@ -22,6 +22,7 @@
 #include "network.h"
 #include "post.h"
 #include "interrupt.h"
+#include "sysdep.h"
 #include <sstream>
 #include <string>
 
@@ -34,6 +35,9 @@
 
 #define MAX_MON_COUNT 50
 #define MAX_ARR_COUNT 10
+#define MAX_RANGE_COUNT 50 // most values in one monitor range get or set (the largest monitor)
+#define WAITER_BLOCK_SIZE 64 // waiter records allocated at a time when the pool runs out
+#define WAKEUP_REPORT_INTERVAL 1000 // with -d n, print the wake-up timing every this many wake-ups
 
 void
 MailTest(int farAddr)
@@ -86,6 +90,109 @@ MailTest(int farAddr)
     interrupt->Halt();
 }
 
+// Network benchmark: both machines stream NetBenchMessages full-size,
+// numbered messages at each other's NetBenchBox at the same time, and
+// each side checks that they arrive complete and in order.  Run it
+// with different -l settings to see what the transport costs under loss.
+// With "longMessages", the same number of bytes goes as MaxMessageSize
+// messages instead, each sent in fragments.
+
+#define NetBenchMessages 2000	// MaxMailSize messages each machine sends
+#define NetBenchBox 1		// mailbox the messages are sent to
+#define NetBenchLingerRounds 20	// timer rounds to keep acking after we're done
+
+static int netBenchFarAddr;
+static int netBenchSize;	// bytes in each message
+static int netBenchCount;	// messages each way
+static Semaphore *netBenchSent;
+
+// fill in message "i" of the benchmark: its number, then a pattern
+static void
+NetBenchFill(char *data, int i)
+{
+    memcpy(data, &i, sizeof(int));
+    for (int k = sizeof(int); k < netBenchSize; k++)
+        data[k] = (char) (i + k);
+}
+
+static void
+NetBenchSender(int arg)
+{
+    PacketHeader outPktHdr;
+    MailHeader outMailHdr;
+    char data[MaxMessageSize];
+
+    outPktHdr.to = netBenchFarAddr;
+    outMailHdr.to = NetBenchBox;
+    outMailHdr.from = NetBenchBox;
+    outMailHdr.length = netBenchSize;
+
+    for (int i = 0; i < netBenchCount; i++) {
+        NetBenchFill(data, i);
+        if (!postOffice->Send(outPktHdr, outMailHdr, data)) {
+            printf("The postOffice Send failed. You must not have the other Nachos running. Terminating Nachos.\n");
+            interrupt->Halt();
+        }
+    }
+    postOffice->Flush();	// wait until the other side has all of them
+    netBenchSent->V();
+}
+
+static void
+NetBenchPauseDone(int arg)
+{
+    ((Semaphore *) arg)->V();
+}
+
+void
+NetworkBenchmark(int farAddr, bool longMessages)
+{
+    PacketHeader inPktHdr;
+    MailHeader inMailHdr;
+    char buffer[MaxMessageSize];
+    char expected[MaxMessageSize];
+    int outOfOrder = 0;
+
+    Delay(2);			// give the user time to start the other nachos
+
+    netBenchFarAddr = farAddr;
+    netBenchSize = longMessages ? MaxMessageSize : MaxMailSize;
+    netBenchCount = NetBenchMessages * MaxMailSize / netBenchSize;
+    netBenchSent = new Semaphore("network benchmark sent", 0);
+    double start = HostSeconds();
+
+    Thread *sender = new Thread("network benchmark sender");
+    sender->Fork(NetBenchSender, 0);
+
+    for (int i = 0; i < netBenchCount; i++) {
+        postOffice->Receive(NetBenchBox, &inPktHdr, &inMailHdr, buffer);
+        NetBenchFill(expected, i);
+        if (inMailHdr.length != (unsigned) netBenchSize ||
+            memcmp(buffer, expected, netBenchSize) != 0)
+            outOfOrder++;
+    }
+    netBenchSent->P();
+    double elapsed = HostSeconds() - start;
+
+    printf("Network benchmark: %d messages of %d bytes each way in %.2f seconds (%.0f messages/second), "
+           "%d out of order, missing or damaged, %d retransmissions\n",
+           netBenchCount, netBenchSize, elapsed, netBenchCount / elapsed, outOfOrder,
+           stats->numRetransmissions);
+    fflush(stdout);
+
+    // The other machine may still be waiting for acks of its last
+    // messages; keep the post office running for a little while.
+    Semaphore *pause = new Semaphore("network benchmark pause", 0);
+    for (int i = 0; i < NetBenchLingerRounds; i++) {
+        interrupt->Schedule(NetBenchPauseDone, (int) pause, RetransmitTimeout,
+                            NetworkTimerInt);
+        pause->P();
+    }
+    delete pause;
+    delete netBenchSent;
+    interrupt->Halt();
+}
+
 // ++++++++++++++++++++++++++++ Declarations ++++++++++++++++++++++++++++
 
 // abstract concept.  Even thought there are no actual threads, it makes it easier
@@ -125,6 +232,120 @@ bool operator==(const ServerThread& t1, const ServerThread& t2) {
     return true;
 }
 
+// a client thread waiting on a lock or condition: where to send its reply,
+// and which reply.  Records are linked into FIFO queues through "next", and
+// go back to a free list when the thread is woken, so waiting and waking
+// never allocate or parse anything
+struct ServerWaiter {
+  int machineId;      // client machine waiting
+  int mailboxNum;     // client mailbox the reply goes to
+  int serverMailbox;  // our mailbox the request came in on
+  int replyIndex;     // index in stringArr of the reply to send when woken
+  ServerWaiter* group; // for a group of one machine's threads woken together (replyIndex 3), the threads
+  ServerWaiter* next;
+};
+
+// FIFO queue of waiting clients
+struct WaiterQueue {
+  ServerWaiter* head;
+  ServerWaiter* tail;
+};
+
+ServerWaiter* freeWaiters = NULL; // pool of unused waiter records
+
+// wake-up timing (-d n only), printed every WAKEUP_REPORT_INTERVAL wake-ups
+int serverWakeups = 0;
+double serverWakeupSeconds = 0;
+
+// get a waiter record from the pool, refilling it a block at a time
+ServerWaiter* allocWaiter() {
+    if(freeWaiters == NULL) {
+        ServerWaiter* block = new ServerWaiter[WAITER_BLOCK_SIZE];
+        for(int i = 0; i < WAITER_BLOCK_SIZE; ++i) {
+            block[i].next = freeWaiters;
+            freeWaiters = &block[i];
+        }
+    }
+    ServerWaiter* waiter = freeWaiters;
+    freeWaiters = waiter->next;
+    waiter->group = NULL;
+    return waiter;
+}
+
+// put a waiter record back in the pool, with the members if it is a group
+void freeWaiter(ServerWaiter* waiter) {
+    ServerWaiter* member = waiter->group;
+    while(member != NULL) {
+        ServerWaiter* next = member->next;
+        member->next = freeWaiters;
+        freeWaiters = member;
+        member = next;
+    }
+    waiter->next = freeWaiters;
+    freeWaiters = waiter;
+}
+
+void initWaiterQueue(WaiterQueue& queue) {
+    queue.head = NULL;
+    queue.tail = NULL;
+}
+
+bool waiterQueueIsEmpty(WaiterQueue& queue) {
+    return queue.head == NULL;
+}
+
+void appendWaiter(WaiterQueue& queue, ServerWaiter* waiter) {
+    waiter->next = NULL;
+    if(queue.tail == NULL) {
+        queue.head = waiter;
+    } else {
+        queue.tail->next = waiter;
+    }
+    queue.tail = waiter;
+}
+
+// take the first waiter off the queue; the queue must not be empty
+ServerWaiter* removeWaiter(WaiterQueue& queue) {
+    ServerWaiter* waiter = queue.head;
+    queue.head = waiter->next;
+    if(queue.head == NULL) {
+        queue.tail = NULL;
+    }
+    return waiter;
+}
+
+// take every waiter off a queue and sort them by client machine, keeping their order: groups[m] gets
+// machine m's waiters, linked through "next", and order[] the machines as they first appear.  returns
+// how many machines there are.  the dispatcher only takes requests from machines below MaxNetworkPeers
+int groupWaitersByMachine(WaiterQueue& queue, ServerWaiter* groups[], int order[]) {
+    ServerWaiter* tails[MaxNetworkPeers];
+    int machines = 0;
+    for(int m = 0; m < MaxNetworkPeers; ++m) {
+        groups[m] = NULL;
+    }
+    while(!waiterQueueIsEmpty(queue)) {
+        ServerWaiter* waiter = removeWaiter(queue);
+        int m = waiter->machineId;
+        ASSERT(m >= 0 && m < MaxNetworkPeers);
+        waiter->next = NULL;
+        if(groups[m] == NULL) {
+            groups[m] = waiter;
+            order[machines++] = m;
+        } else {
+            tails[m]->next = waiter;
+        }
+        tails[m] = waiter;
+    }
+    return machines;
+}
+
+// give every waiter on the queue back to the pool
+void clearWaiterQueue(WaiterQueue& queue) {
+    while(!waiterQueueIsEmpty(queue)) {
+        freeWaiter(removeWaiter(queue));
+    }
+}
+
 // lock implementation for server
 struct ServerLock {
     int num;
@@ -134,9 +355,11 @@ struct ServerLock {
     enum LockStatus {FREE, BUSY};
     LockStatus lockStatus;
     char* name;
-    List* waitQueue;
+    WaiterQueue waitQueue;
     int queueSize;
     ServerThread lockOwner;
+    bool cached;     // the owner is a client machine's lock cache rather than one of its threads
+    bool revokeSent; // we have asked that machine to give the lock back
 };
 
 // operator overload for == on ServerLock
@@ -165,7 +388,7 @@ bool lockIsNull(ServerLock lock) {
         return FALSE;
     }
 
-    if(lock.waitQueue != NULL) {
+    if(!waiterQueueIsEmpty(lock.waitQueue)) {
         return FALSE;
     }
 
@@ -185,9 +408,11 @@ void setLockToNull(ServerLock& lock) {
     lock.isDeleted = FALSE;
 
     lock.lockStatus = lock.FREE;
-    lock.waitQueue = NULL;
+    initWaiterQueue(lock.waitQueue);
     lock.lockOwner.machineId = -1;
     lock.lockOwner.mailboxNum = -1;
+    lock.cached = FALSE;
+    lock.revokeSent = FALSE;
 }
 
 // condition implementation on the server
@@ -197,7 +422,8 @@ struct ServerCond {
 
     char* name;
     int waitingLockIndex;
-    List* waitQueue;
+    int remoteLockIndex; // global index of the lock on another server that the waiters use, or -1
+    WaiterQueue waitQueue;
     int queueSize;
     bool hasWaitingLock;
 };
@@ -207,7 +433,9 @@ struct ServerMon {
     bool deleteFlag;
     bool isDeleted;
     int* values;
+    int size; // how many values
     char* name;
+    bool leased[MaxNetworkPeers]; // has each client machine leased the values since they last changed?
 };
 
 // a message struct that holds the pktHdr mailHdr and message
@@ -229,13 +457,34 @@ ServerLock serverLocks[MAX_MON_COUNT];
 ServerMon serverMons[MAX_MON_COUNT];
 ServerCond serverConds[MAX_MON_COUNT];
 
+// a condition's Wait, Signal and Broadcast go to the worker that has the lock they name, and its destroy
+// to the worker that has the condition, so several workers can get requests for the same condition: the
+// one handling a request holds the condition's serverCondLock
+Lock* serverCondLocks[MAX_MON_COUNT];
+
 // server counts of the locks, mons, and conds
 int serverLockCount = 0;
 int serverMonCount = 0;
 int serverCondCount = 0;
 
+// which of the numServers servers this is (its machine id, 0 to numServers - 1)
+int serverIndex = 0;
+
 // ++++++++++++++++++++++++++++ Validation ++++++++++++++++++++++++++++
 
+// take or give back the serverCondLock of a condition (a local index), if there is such a condition
+void lockServerCond(int conditionIndex) {
+    if(conditionIndex >= 0 && conditionIndex < MAX_MON_COUNT) {
+        serverCondLocks[conditionIndex]->Acquire();
+    }
+}
+
+void unlockServerCond(int conditionIndex) {
+    if(conditionIndex >= 0 && conditionIndex < MAX_MON_COUNT) {
+        serverCondLocks[conditionIndex]->Release();
+    }
+}
+
 // make sure that we were handed a valid lock
 bool validateLockIndex(int lockIndex) {
     if (lockIndex < 0 || lockIndex >= serverLockCount){ // check if index is in valid range
@@ -270,6 +519,38 @@ bool validateArrayIndex(int arrayIndex) {
     }
     return true;
 }
+
+// make sure a range of a monitor's values is inside its array
+bool validateArrayRange(int monitorIndex, int first, int count) {
+    if (first < 0 || count < 0 || count > MAX_RANGE_COUNT || first + count > serverMons[monitorIndex].size){
+      DEBUG('l',"    Mon::Array range %d, %d invalid\n", first, count);
+      return false;
+    }
+    return true;
+}
+// the servers split the entities between them.  entity "local" in the tables of server s
+// is known to the clients as local * numServers + s, so anyone can tell from an entity's
+// index which server has it
+int globalIndex(int local) {
+    if (local < 0){
+      return -1;
+    }
+    return local * numServers + serverIndex;
+}
+
+// the index in our tables of an entity index from a client, or -1 if it is not one of ours
+int localIndex(int global) {
+    if (global < 0 || global % numServers != serverIndex){
+      return -1;
+    }
+    return global / numServers;
+}
+
+// is an entity index one of ours?  (a bad index counts as ours, so that we reply with an error)
+bool isLocalIndex(int global) {
+    return global < 0 || global % numServers == serverIndex;
+}
+
 // make sure that we were handed a valid condition
 bool validateConditionIndex(int conditionIndex) {
     if (conditionIndex < 0 || conditionIndex >= serverCondCount){ // check if index is in valid range
@@ -283,69 +564,130 @@ bool validateConditionIndex(int conditionIndex) {
     return true;
 }
 
+// someone else wants a lock that a client machine has cached: ask that machine's lock cache to give it
+// back (LockCacheRevoke and the lock's global index).  it releases the lock as soon as no thread of its own holds it
+void revokeCachedLock(int lockIndex){
+  ServerLock &lock = serverLocks[lockIndex];
+  if(!lock.cached || lock.revokeSent) {
+    return;
+  }
+  PacketHeader outPktHdr;
+  MailHeader outMailHdr;
+  stringstream ss;
+  ss << LockCacheRevoke << ' ' << globalIndex(lockIndex);
+  string str = ss.str();
+
+  outPktHdr.to = lock.lockOwner.machineId;
+  outMailHdr.to = lock.lockOwner.mailboxNum;
+  outMailHdr.from = 0;
+  outMailHdr.length = str.size() + 1;
+  postOffice->Send(outPktHdr, outMailHdr, (char*) str.c_str());
+  lock.revokeSent = TRUE;
+}
+
+// a lock waiter has been woken: make it the lock owner, send it its reply and recycle its record.
+// a machine's lock cache is told which lock it got (and, for a group, which of its threads to hand it
+// to), and is asked for it back at once if others are waiting
+void wakeLockWaiter(int lockIndex, PacketHeader &pktHdr, MailHeader &mailHdr){
+  bool timed = DebugIsEnabled('n');
+  double start = timed ? HostSeconds() : 0;
+  ServerWaiter* waiter = removeWaiter(serverLocks[lockIndex].waitQueue);
+  pktHdr.to = waiter->machineId;
+  mailHdr.to = waiter->mailboxNum;
+  mailHdr.from = waiter->serverMailbox;
+  serverLocks[lockIndex].lockOwner.machineId = waiter->machineId; //the waiter owns the lock now
+  serverLocks[lockIndex].lockOwner.mailboxNum = waiter->mailboxNum;
+  serverLocks[lockIndex].cached = (waiter->replyIndex == 2 || waiter->replyIndex == 3);
+  serverLocks[lockIndex].revokeSent = FALSE;
+  stringstream ss;
+  ss << stringArr[waiter->replyIndex];
+  if(serverLocks[lockIndex].cached) {
+    ss << ' ' << globalIndex(lockIndex);
+  }
+  for(ServerWaiter* member = waiter->group; member != NULL; member = member->next) {
+    ss << ' ' << member->mailboxNum; // the machine hands the lock to these threads in turn
+  }
+  string str = ss.str();
+  mailHdr.length = str.size() + 1;
+  postOffice->Send(pktHdr, mailHdr, (char*) str.c_str());
+  freeWaiter(waiter);
+  if(!waiterQueueIsEmpty(serverLocks[lockIndex].waitQueue)) {
+    revokeCachedLock(lockIndex);
+  }
+
+  if(timed) {
+    serverWakeupSeconds += HostSeconds() - start;
+    if(++serverWakeups % WAKEUP_REPORT_INTERVAL == 0) {
+      DEBUG('n', "Server: %d lock wake-ups, %.2f us each\n", serverWakeups,
+          serverWakeupSeconds * 1e6 / serverWakeups);
+    }
+  }
+}
+
+// queue the threads of one client machine that a Broadcast woke (linked through "next") to get the lock
+// back.  two or more go in one group record: when it reaches the front of the queue the lock is granted
+// to the machine's lock cache with one message naming all of them ("B", the lock's global index and their
+// mailboxes), and the machine passes the lock from thread to thread itself
+void appendWakeGroup(int lockIndex, ServerWaiter* members) {
+  ServerWaiter* record = members;
+  if(members->next == NULL) {
+    members->replyIndex = 0; // "You got the lock!"
+  } else {
+    record = allocWaiter();
+    record->machineId = members->machineId;
+    record->mailboxNum = LockCacheMailbox;
+    record->serverMailbox = members->serverMailbox;
+    record->replyIndex = 3;
+    record->group = members;
+  }
+  appendWaiter(serverLocks[lockIndex].waitQueue, record);
+  if(serverLocks[lockIndex].lockStatus == serverLocks[lockIndex].FREE) { // the broadcaster did not hold it
+    PacketHeader outPktHdr;
+    MailHeader outMailHdr;
+    serverLocks[lockIndex].lockStatus = serverLocks[lockIndex].BUSY;
+    wakeLockWaiter(lockIndex, outPktHdr, outMailHdr);
+  } else {
+    revokeCachedLock(lockIndex);
+  }
+}
+
 // a function to release the lock on the server side without actually sending any messages out to the postOffice
 // identical to Release_server aside from messages.
 void serverReleaseLock(int lockIndex, PacketHeader &pktHdr, MailHeader &mailHdr){
   cout << "Releasing lock in server Release\n";
-  if(!serverLocks[lockIndex].waitQueue->IsEmpty()) //lock waitQueue is not empty
+  if(!waiterQueueIsEmpty(serverLocks[lockIndex].waitQueue)) //lock waitQueue is not empty
   {
-    string* msg;
-    int stringIndex;
-    stringstream ss;
-    msg = (string*) serverLocks[lockIndex].waitQueue->Remove();
-    ss << *msg;
-    cout << *msg << endl;
-    ss >> pktHdr.to;
-    ss >> mailHdr.to;
-    ss >> mailHdr.from;
-    serverLocks[lockIndex].lockOwner.machineId = pktHdr.to; //unset ownership
-    serverLocks[lockIndex].lockOwner.mailboxNum = mailHdr.to; //unset ownership
-    cout << stringArr[stringIndex];
-    cout << stringArr[stringIndex].length();
-    mailHdr.length = stringArr[stringIndex].length();
-    char buf[stringArr[stringIndex].length() + 1];
-    for(unsigned int i = 0; i < stringArr[stringIndex].length(); ++i) {
-      buf[i] = stringArr[stringIndex][i];
-    }
-    buf[stringArr[stringIndex].length()]= '\0';
-    postOffice->Send(pktHdr, mailHdr, buf);
+    wakeLockWaiter(lockIndex, pktHdr, mailHdr);
   }
   else
   {
       serverLocks[lockIndex].lockStatus = serverLocks[lockIndex].FREE; //make lock available
       serverLocks[lockIndex].lockOwner.machineId = -1; //unset ownership
       serverLocks[lockIndex].lockOwner.mailboxNum = -1; //unset ownership
+      serverLocks[lockIndex].cached = FALSE;
       cout << "Lock released after \n";
   }
 }
 
+// a helper function to record a client waiting in a queue: who to reply to once it is woken and which reply
+// the headers are those of the client's request, so we swap the to and from
+ServerWaiter* makeWaiter(PacketHeader &pktHdr, MailHeader &mailHdr, int replyIndex){
+  ServerWaiter* waiter = allocWaiter();
+  waiter->machineId = pktHdr.from;
+  waiter->mailboxNum = mailHdr.from;
+  waiter->serverMailbox = mailHdr.to;
+  waiter->replyIndex = replyIndex;
+  return waiter;
+}
+
 // a helper function to place messages into lock waitqueues
-// we swap the header to froms and parse the data, encoded into strings and append the message to lock waitqueues
 void putMsgLock(PacketHeader &pktHdr, MailHeader &mailHdr, char* data, int lockIndex){
-  pktHdr.to = pktHdr.from;
-  int temp = mailHdr.to;
-  mailHdr.to = mailHdr.from;
-  mailHdr.from = temp;
-  string *msg = new string();
-  stringstream ss;
-  ss << pktHdr.to << ' ' << mailHdr.to << ' ' << mailHdr.from << ' ' << 0;
-  *msg = ss.str();
-  serverLocks[lockIndex].waitQueue->Append(msg); //Put current thread on the lock’s waitQueue
+  appendWaiter(serverLocks[lockIndex].waitQueue, makeWaiter(pktHdr, mailHdr, 0)); //Put current thread on the lock’s waitQueue
 }
 
 // a helper function to place messages into condition waitqueues
-// we swap the header to froms and parse the data, encoded into strings and append the message to the queue
 void putMsgCond(PacketHeader &pktHdr, MailHeader &mailHdr, char* data, int conditionIndex){
-  pktHdr.to = pktHdr.from;
-  int temp = mailHdr.to;
-  mailHdr.to = mailHdr.from;
-  mailHdr.from = temp;
-  string *msg = new string();
-  stringstream ss;
-  ss << pktHdr.to << ' ' << mailHdr.to << ' ' << mailHdr.from << ' ' << 1;
-  *msg = ss.str();
-
-  serverConds[conditionIndex].waitQueue->Append(msg); //Put current thread on the lock’s waitQueue
+  appendWaiter(serverConds[conditionIndex].waitQueue, makeWaiter(pktHdr, mailHdr, 1)); //Put current thread on the condition’s waitQueue
 }
 
 
@@ -362,18 +704,18 @@ void sendMessageToClient(char* data, PacketHeader &pktHdr, MailHeader &mailHdr)
 
     bool success = postOffice->Send(pktHdr, mailHdr, data);
 
-    if ( !success ) {
-        printf("Release::The first postOffice Send failed. You must not have the other Nachos running. Terminating Nachos.\n");
-        interrupt->Halt();
+    if ( !success ) { // the client is gone; that must not stop the server
+        printf("Server: machine %d is not answering, reply dropped\n", pktHdr.to);
     }
 }
 
 // abstract method to send message to the client from the server
 // another helper function to encode entity index messages
 void sendCreateEntityMessage(stringstream &ss, PacketHeader &pktHdr, MailHeader &mailHdr) {
-    const char* tempChar = ss.str().c_str();
+    string str = ss.str(); // keep the string alive while we copy it
+    const char* tempChar = str.c_str();
     // cout << "tempChar: " << ss.str() << endl;
-    char replyBuffer[MaxMailSize];
+    char replyBuffer[MaxMessageSize];
     for(unsigned int i = 0; i < strlen(tempChar); ++i) {
         replyBuffer[i] = tempChar[i];
     }
@@ -388,9 +730,8 @@ void sendCreateEntityMessage(stringstream &ss, PacketHeader &pktHdr, MailHeader
     mailHdr.length = strlen(tempChar) + 1;
     bool success = postOffice->Send(pktHdr, mailHdr, replyBuffer);
 
-    if ( !success ) {
-        printf("The postOffice Send failed. You must not have the other Nachos running. Terminating Nachos.\n");
-        interrupt->Halt();
+    if ( !success ) { // the client is gone; that must not stop the server
+        printf("Server: machine %d is not answering, reply dropped\n", pktHdr.to);
     }
 }
 
@@ -424,6 +765,8 @@ int CreateLock_server(char* name, int appendNum, PacketHeader &pktHdr, MailHeade
     serverLocks[serverLockCount].name[strlen(name)] = '\0';
     serverLocks[serverLockCount].lockOwner.machineId = -1;
     serverLocks[serverLockCount].lockOwner.mailboxNum = -1;
+    serverLocks[serverLockCount].cached = FALSE;
+    serverLocks[serverLockCount].revokeSent = FALSE;
 
     int currentLockIndex = serverLockCount;
     serverLocks[serverLockCount].num = currentLockIndex;
@@ -457,13 +800,122 @@ void Acquire_server(int lockIndex, PacketHeader &pktHdr, MailHeader &mailHdr) {
         //serverLocks[lockIndex].lockOwner = serverCurrentThread; //make myself the owner
         serverLocks[lockIndex].lockOwner.machineId = pktHdr.from;
         serverLocks[lockIndex].lockOwner.mailboxNum = mailHdr.from;
+        serverLocks[lockIndex].cached = FALSE;
         sendMessageToClient("You got the lock!", pktHdr, mailHdr); //send the message to the client
         return;
     }
     else //lock is busy
     {
       putMsgLock(pktHdr, mailHdr, "You got the lock!", lockIndex); //put the message on the waitqueue so that it can be sent when someone releases the lock
+      revokeCachedLock(lockIndex); // if a machine is only keeping it cached, ask for it back
+    }
+}
+
+// acquire a lock for a client machine's lock cache.  the request comes from the cache's mailbox, which
+// owns the lock until the machine gives it back, so the machine's threads can take and release it
+// without asking us.  the reply (LockCacheGrant and the global index) says which lock the cache got;
+// LockCacheNoLock and the index if there is no such lock, so the cache stops trying to keep it
+void AcquireCached_server(int globalLockIndex, PacketHeader &pktHdr, MailHeader &mailHdr) {
+    int lockIndex = localIndex(globalLockIndex);
+    if(!validateLockIndex(lockIndex)) {
+        stringstream ss;
+        ss << LockCacheNoLock << ' ' << globalLockIndex;
+        sendCreateEntityMessage(ss, pktHdr, mailHdr);
+        return;
     }
+    ServerThread serverCurrentThread;
+    serverCurrentThread.machineId = pktHdr.from;
+    serverCurrentThread.mailboxNum = mailHdr.from;
+
+    if(serverCurrentThread == serverLocks[lockIndex].lockOwner) { // the machine has it already (a Broadcast's group)
+        stringstream ss;
+        ss << stringArr[2] << ' ' << globalLockIndex;
+        sendCreateEntityMessage(ss, pktHdr, mailHdr);
+        return;
+    }
+    if(serverLocks[lockIndex].lockStatus == serverLocks[lockIndex].FREE) {
+        serverLocks[lockIndex].lockStatus = serverLocks[lockIndex].BUSY;
+        serverLocks[lockIndex].lockOwner = serverCurrentThread;
+        serverLocks[lockIndex].cached = TRUE;
+        serverLocks[lockIndex].revokeSent = FALSE;
+        stringstream ss;
+        ss << stringArr[2] << ' ' << globalLockIndex;
+        sendCreateEntityMessage(ss, pktHdr, mailHdr);
+        return;
+    }
+    appendWaiter(serverLocks[lockIndex].waitQueue, makeWaiter(pktHdr, mailHdr, 2));
+    revokeCachedLock(lockIndex);
+}
+
+// a client thread that holds a lock through its machine's lock cache is about to wait on a condition:
+// make the thread itself the owner, so the condition can release and reacquire the lock for it
+void HandOver_server(int lockIndex, PacketHeader &pktHdr, MailHeader &mailHdr) {
+    if(!validateLockIndex(lockIndex)) {
+        sendMessageToClient("Invalid lock index!", pktHdr, mailHdr);
+        return;
+    }
+    ServerThread cache;
+    cache.machineId = pktHdr.from;
+    cache.mailboxNum = LockCacheMailbox;
+    if(!(serverLocks[lockIndex].lockOwner == cache)) {
+        sendMessageToClient("Lock is not cached!", pktHdr, mailHdr);
+        return;
+    }
+    serverLocks[lockIndex].lockOwner.mailboxNum = mailHdr.from;
+    serverLocks[lockIndex].cached = FALSE;
+    serverLocks[lockIndex].revokeSent = FALSE;
+    sendMessageToClient("Lock handed over!", pktHdr, mailHdr);
+}
+
+// acquire a lock for a client thread that was waiting on a condition on another server.  the
+// client gets our reply when it has the lock, just as if it had asked for the lock itself
+void AcquireFor_server(int lockIndex, int machineId, int mailboxNum, PacketHeader &pktHdr, MailHeader &mailHdr) {
+    pktHdr.from = machineId;
+    mailHdr.from = mailboxNum;
+    Acquire_server(lockIndex, pktHdr, mailHdr);
+}
+
+// acquire a lock for a group of one machine's threads woken by a Broadcast of a condition on another
+// server.  "mailboxes" holds their mailboxes, from the request
+void AcquireGroupFor_server(int lockIndex, int machineId, stringstream &mailboxes, PacketHeader &pktHdr, MailHeader &mailHdr) {
+    if(!validateLockIndex(lockIndex)) {
+        cout << "AcquireGroupFor_server: invalid lock " << lockIndex << endl;
+        return;
+    }
+    ServerWaiter* members = NULL;
+    ServerWaiter* tail = NULL;
+    int mailboxNum;
+    while(mailboxes >> mailboxNum) {
+        ServerWaiter* member = allocWaiter();
+        member->machineId = machineId;
+        member->mailboxNum = mailboxNum;
+        member->serverMailbox = mailHdr.to;
+        member->next = NULL;
+        if(tail == NULL) {
+            members = member;
+        } else {
+            tail->next = member;
+        }
+        tail = member;
+    }
+    if(members != NULL) {
+        appendWakeGroup(lockIndex, members);
+    }
+}
+
+// release a lock for a client thread that has started waiting on a condition on another server.
+// no reply unless it no longer holds the lock; otherwise the client is waiting for the condition
+void ReleaseFor_server(int lockIndex, int machineId, int mailboxNum, PacketHeader &pktHdr, MailHeader &mailHdr) {
+    ServerThread thread;
+    thread.machineId = machineId;
+    thread.mailboxNum = mailboxNum;
+    if(!validateLockIndex(lockIndex) || !(serverLocks[lockIndex].lockOwner == thread)) {
+        pktHdr.from = machineId;
+        mailHdr.from = mailboxNum;
+        sendMessageToClient("Lock is not acquired!", pktHdr, mailHdr);
+        return;
+    }
+    serverReleaseLock(lockIndex, pktHdr, mailHdr);
 }
 
 // create release server call
@@ -486,40 +938,23 @@ void Release_server(int lockIndex, PacketHeader &pktHdr, MailHeader &mailHdr) {
 
     if (serverLocks[lockIndex].deleteFlag == TRUE){
       serverLocks[lockIndex].isDeleted = TRUE;
-      delete serverLocks[lockIndex].waitQueue;
+      clearWaiterQueue(serverLocks[lockIndex].waitQueue);
       delete serverLocks[lockIndex].name;
       sendMessageToClient("Released, the lock is also deleted.", pktHdr, mailHdr);
       return;
     }
-    if(!serverLocks[lockIndex].waitQueue->IsEmpty()) //lock waitQueue is not empty
+    if(!waiterQueueIsEmpty(serverLocks[lockIndex].waitQueue)) //lock waitQueue is not empty
     {
-      // compliated code to get messages from the waitqueue, decode it and send it out
+      // reply to the releaser, then hand the lock to the first waiter
       sendMessageToClient("Released. Another thread took it.", pktHdr, mailHdr);
-      string* msg;
-      stringstream ss;
-      int stringIndex;
-      msg = (string*) (serverLocks[lockIndex].waitQueue->Remove());
       --(serverLocks[lockIndex].queueSize);
-      ss << *msg;
-      ss >> pktHdr.to;
-      ss >> mailHdr.to;
-      ss >> mailHdr.from;
-      ss >> stringIndex;
-      serverLocks[lockIndex].lockOwner.machineId = pktHdr.to; //unset ownership
-      serverLocks[lockIndex].lockOwner.mailboxNum = mailHdr.to; //unset ownership
-
-      mailHdr.length = stringArr[stringIndex].length()+1;
-      char buf[stringArr[stringIndex].length() + 1];
-      for(unsigned int i = 0; i < stringArr[stringIndex].length(); ++i) {
-        buf[i] = stringArr[stringIndex][i];
-      } //copy the char*
-      buf[stringArr[stringIndex].length()]= '\0';
-      postOffice->Send(pktHdr, mailHdr, buf);
+      wakeLockWaiter(lockIndex, pktHdr, mailHdr);
     } else {
         // queue is empty
         serverLocks[lockIndex].lockStatus = serverLocks[lockIndex].FREE; //make lock available
         serverLocks[lockIndex].lockOwner.machineId = -1; //unset ownership
         serverLocks[lockIndex].lockOwner.mailboxNum = -1; //unset ownership
+        serverLocks[lockIndex].cached = FALSE;
         sendMessageToClient("You released the lock!", pktHdr, mailHdr);
     }
 }
@@ -546,11 +981,81 @@ void DestroyLock_server(int lockIndex, PacketHeader &pktHdr, MailHeader &mailHdr
         serverLocks[lockIndex].lockOwner.machineId = -1; //unset ownership
         serverLocks[lockIndex].lockOwner.mailboxNum = -1; //unset ownership
         serverLocks[lockIndex].isDeleted = TRUE; //unset ownership
-        delete serverLocks[lockIndex].waitQueue;
+        clearWaiterQueue(serverLocks[lockIndex].waitQueue);
         sendMessageToClient("You destroyed the lock!", pktHdr, mailHdr);
     }
 }
 
+// send a request to the server that has the lock or condition "entityIndex" (a global index)
+void sendToServerOf(int entityIndex, string str) {
+    PacketHeader outPktHdr;
+    MailHeader outMailHdr;
+
+    outPktHdr.to = entityIndex % numServers;
+    outMailHdr.to = 0;
+    outMailHdr.from = 0;
+    outMailHdr.length = str.size() + 1;
+    bool success = postOffice->Send(outPktHdr, outMailHdr, (char*) str.c_str());
+
+    if ( !success ) {
+        printf("The postOffice Send failed. You must not have the other Nachos running. Terminating Nachos.\n");
+        interrupt->Halt();
+    }
+}
+
+// ask the server that has lock "lockIndex" (a global index) to acquire or release it for a client
+// thread waiting on one of our conditions: code 'a' to acquire (that server replies to the client
+// once it has the lock) or 'r' to release
+void sendLockRequestFor(char code, int lockIndex, int machineId, int mailboxNum) {
+    stringstream ss;
+    ss << "L " << code << ' ' << lockIndex << ' ' << machineId << ' ' << mailboxNum;
+    sendToServerOf(lockIndex, ss.str());
+}
+
+// ask the server that has lock "lockIndex" to acquire it for a group of one machine's threads that a
+// Broadcast of one of our conditions woke ("L b", the machine, then their mailboxes).  frees the records
+void sendGroupLockRequestFor(int lockIndex, ServerWaiter* members) {
+    stringstream ss;
+    ss << "L b " << lockIndex << ' ' << members->machineId;
+    while(members != NULL) {
+        ServerWaiter* next = members->next;
+        ss << ' ' << members->mailboxNum;
+        freeWaiter(members);
+        members = next;
+    }
+    sendToServerOf(lockIndex, ss.str());
+}
+
+// check that a client thread holds one of our locks before the server that has the condition lets
+// it wait on (op 'W') or signal ('S', 'B') the condition with it: if so we send the request back to
+// that server as "C V", otherwise we reply to the client with the error.  a waiter has taken the
+// lock out of its machine's lock cache ("L H"), but a signaller may still hold it through the cache
+void CheckOwnerFor_server(int lockIndex, int conditionIndex, char op, int machineId, int mailboxNum, PacketHeader &pktHdr, MailHeader &mailHdr) {
+    ServerThread thread;
+    thread.machineId = machineId;
+    thread.mailboxNum = mailboxNum;
+    bool owner = FALSE;
+    if(validateLockIndex(lockIndex)) {
+        owner = serverLocks[lockIndex].lockOwner == thread ||
+            (op != 'W' && serverLocks[lockIndex].cached && serverLocks[lockIndex].lockOwner.machineId == machineId);
+    }
+    if(!owner) {
+        pktHdr.from = machineId;
+        mailHdr.from = mailboxNum;
+        if(op == 'W') {
+            sendMessageToClient("No permission to wait!", pktHdr, mailHdr);
+        } else if(op == 'S') {
+            sendMessageToClient("No permission to signal!", pktHdr, mailHdr);
+        } else {
+            sendMessageToClient("No permission to broadcast!", pktHdr, mailHdr);
+        }
+        return;
+    }
+    stringstream ss;
+    ss << "C V " << globalIndex(lockIndex) << ' ' << conditionIndex << ' ' << op << ' ' << machineId << ' ' << mailboxNum;
+    sendToServerOf(conditionIndex, ss.str());
+}
+
 // ++++++++++++++++++++++++++++ MVs ++++++++++++++++++++++++++++
 
 // create monitor server call
@@ -581,6 +1086,10 @@ int CreateMonitor_server(char* name, int appendNum, PacketHeader &pktHdr, MailHe
   strncpy(serverMons[serverMonCount].name, name, strlen(name));
   serverMons[serverMonCount].name[strlen(name)] = '\0';
   serverMons[serverMonCount].values = new int [appendNum];
+  serverMons[serverMonCount].size = appendNum;
+  for (int i = 0; i < MaxNetworkPeers; ++i){
+    serverMons[serverMonCount].leased[i] = FALSE;
+  }
 
   int currentMonIndex = serverMonCount;
   ++serverMonCount;
@@ -600,14 +1109,150 @@ int GetMonitor_server(int monitorIndex, int arrayIndex,PacketHeader &pktHdr, Mai
         return -1;
     }
     // we return the required value for monitor
-    char temp;
     stringstream ss;
     ss << serverMons[monitorIndex].values[arrayIndex];
-    ss >> temp;
-    sendMessageToClient(&temp, pktHdr, mailHdr);
+    sendCreateEntityMessage(ss, pktHdr, mailHdr);
     return serverMons[monitorIndex].values[arrayIndex];
 }
 
+// get monitor value with a lease server call.  like GetMonitor, but the client machine may keep the
+// value for "leaseTicks", and we tell its monitor cache ("U" and the global index) if the monitor is
+// set before then.  the machines' clocks are separate and don't run at the same rate (an idle machine
+// jumps ahead to its next timer), so we don't time the lease: the machine is told of the next change
+// whenever it comes, and the client times the lease itself
+int LeaseMonitor_server(int monitorIndex, int arrayIndex, int leaseTicks, PacketHeader &pktHdr, MailHeader &mailHdr) {
+    int client = pktHdr.from;
+    if(client < 0 || client >= MaxNetworkPeers || leaseTicks < 0) {
+      sendMessageToClient("Invalid lease!", pktHdr, mailHdr);
+        return -1;
+    }
+    int value = GetMonitor_server(monitorIndex, arrayIndex, pktHdr, mailHdr);
+    if(validateMonitorIndex(monitorIndex) && validateArrayIndex(arrayIndex)) {
+      serverMons[monitorIndex].leased[client] = TRUE;
+    }
+    return value;
+}
+
+// a monitor's values are about to change: tell every client machine that leased them since the last
+// change to forget them, whether or not its lease has ended by our clock.  that includes the machine
+// changing them, since another of its threads may have read the old value after this one cleared its
+// cache and before we got the write
+void invalidateMonitorLeases(int monitorIndex) {
+    PacketHeader outPktHdr;
+    MailHeader outMailHdr;
+    stringstream ss;
+    ss << "U " << globalIndex(monitorIndex);
+    string str = ss.str();
+
+    outMailHdr.to = MonitorCacheMailbox;
+    outMailHdr.from = 0;
+    outMailHdr.length = str.size() + 1;
+    for (int client = 0; client < MaxNetworkPeers; ++client){
+      if (serverMons[monitorIndex].leased[client]){
+        serverMons[monitorIndex].leased[client] = FALSE;
+        outPktHdr.to = client;
+        postOffice->Send(outPktHdr, outMailHdr, (char*) str.c_str());
+      }
+    }
+}
+
+// get a range of monitor values server call.  all of them go back in one reply
+void GetMonitorRange_server(int monitorIndex, int first, int count, PacketHeader &pktHdr, MailHeader &mailHdr) {
+    if(!validateMonitorIndex(monitorIndex)) {
+      sendMessageToClient("Invalid monitor index!", pktHdr, mailHdr);
+        return;
+    }
+    if (!validateArrayRange(monitorIndex, first, count)){
+      sendMessageToClient("Invalid array range!", pktHdr, mailHdr);
+        return;
+    }
+    stringstream ss;
+    for (int i = 0; i < count; ++i){
+      ss << serverMons[monitorIndex].values[first + i] << ' ';
+    }
+    sendCreateEntityMessage(ss, pktHdr, mailHdr);
+}
+
+// set a range of monitor values server call.  the values are the rest of the request in "values";
+// the reply is how many were set
+void SetMonitorRange_server(int monitorIndex, int first, int count, stringstream &values, PacketHeader &pktHdr, MailHeader &mailHdr) {
+    if(!validateMonitorIndex(monitorIndex)) {
+      sendMessageToClient("Invalid monitor index!", pktHdr, mailHdr);
+        return;
+    }
+    if (count > MaxMonitorRange || !validateArrayRange(monitorIndex, first, count)){
+      sendMessageToClient("Invalid array range!", pktHdr, mailHdr);
+        return;
+    }
+    int newValues[MaxMonitorRange];
+    for (int i = 0; i < count; ++i){
+      if (!(values >> newValues[i]) || newValues[i] == MonitorError){
+        sendMessageToClient("Invalid monitor value!", pktHdr, mailHdr);
+        return;
+      }
+    }
+    invalidateMonitorLeases(monitorIndex);
+    for (int i = 0; i < count; ++i){
+      serverMons[monitorIndex].values[first + i] = newValues[i];
+    }
+    stringstream ss;
+    ss << count;
+    sendCreateEntityMessage(ss, pktHdr, mailHdr);
+}
+
+// compare and swap monitor server call.  sets the value only if it is still "expected", and
+// replies "OK" and the value it had, so the client can tell whether it won (and an error from a
+// value)
+int CompareAndSwapMonitor_server(int monitorIndex, int arrayIndex, int expected, int newValue, PacketHeader &pktHdr, MailHeader &mailHdr) {
+    if(!validateMonitorIndex(monitorIndex)) {
+      sendMessageToClient("Invalid monitor index!", pktHdr, mailHdr);
+        return -1;
+    }
+    if (!validateArrayRange(monitorIndex, arrayIndex, 1)){
+      sendMessageToClient("Invalid array index!", pktHdr, mailHdr);
+        return -1;
+    }
+    if (newValue == MonitorError){
+      sendMessageToClient("Invalid monitor value!", pktHdr, mailHdr);
+        return -1;
+    }
+    int oldValue = serverMons[monitorIndex].values[arrayIndex];
+    if (oldValue == expected){
+      invalidateMonitorLeases(monitorIndex);
+      serverMons[monitorIndex].values[arrayIndex] = newValue;
+    }
+    stringstream ss;
+    ss << "OK " << oldValue;
+    sendCreateEntityMessage(ss, pktHdr, mailHdr);
+    return oldValue;
+}
+
+// fetch and add monitor server call.  replies "OK" and the value before the add
+int FetchAndAddMonitor_server(int monitorIndex, int arrayIndex, int amount, PacketHeader &pktHdr, MailHeader &mailHdr) {
+    if(!validateMonitorIndex(monitorIndex)) {
+      sendMessageToClient("Invalid monitor index!", pktHdr, mailHdr);
+        return -1;
+    }
+    if (!validateArrayRange(monitorIndex, arrayIndex, 1)){
+      sendMessageToClient("Invalid array index!", pktHdr, mailHdr);
+        return -1;
+    }
+    int oldValue = serverMons[monitorIndex].values[arrayIndex];
+    int newValue = (int) ((unsigned int) oldValue + (unsigned int) amount); // wraps around
+    if (newValue == MonitorError){
+      sendMessageToClient("Invalid monitor value!", pktHdr, mailHdr);
+        return -1;
+    }
+    if (amount != 0){
+      invalidateMonitorLeases(monitorIndex);
+    }
+    serverMons[monitorIndex].values[arrayIndex] = newValue;
+    stringstream ss;
+    ss << "OK " << oldValue;
+    sendCreateEntityMessage(ss, pktHdr, mailHdr);
+    return oldValue;
+}
+
 // set monitor server call
 void SetMonitor_server(int monitorIndex, int arrayIndex, int value,PacketHeader &pktHdr, MailHeader &mailHdr) {
     // set the value and return the message
@@ -619,6 +1264,11 @@ void SetMonitor_server(int monitorIndex, int arrayIndex, int value,PacketHeader
       sendMessageToClient("Invalid array index!", pktHdr, mailHdr);
         return;
     }
+    if (value == MonitorError){
+      sendMessageToClient("Invalid monitor value!", pktHdr, mailHdr);
+        return;
+    }
+    invalidateMonitorLeases(monitorIndex); // before the reply, so the invalidations go out first
     serverMons[monitorIndex].values[arrayIndex] = value;
     sendMessageToClient("Set monitor successfully!", pktHdr, mailHdr);
 
@@ -630,6 +1280,7 @@ void DestroyMonitor_server(int monitorIndex, PacketHeader &pktHdr, MailHeader &m
       sendMessageToClient("Invalid monitor index!", pktHdr, mailHdr);
         return;
     }
+    invalidateMonitorLeases(monitorIndex);
     serverMons[serverMonCount].isDeleted = TRUE;
     delete serverMons[serverMonCount].values;
     sendMessageToClient("Deleted monitor successfully!", pktHdr, mailHdr);
@@ -713,18 +1364,16 @@ void Signal_server(int lockIndex, int conditionIndex, PacketHeader &pktHdr, Mail
   int tempMailFrom = mailHdr.to;
   if(!validateConditionIndex(conditionIndex)) {
     sendMessageToClient("Invalid cond index!", pktHdr, mailHdr);
-  }else if(serverConds[conditionIndex].waitQueue->IsEmpty()) //no thread waiting
+  }else if(waiterQueueIsEmpty(serverConds[conditionIndex].waitQueue)) //no thread waiting
   {
     sendMessageToClient("No thread waiting!", pktHdr, mailHdr);
   } else {
-    // we remove the message from the queue, decode it and use it to acquire the lock after being signaled
-    string* msg;
-    stringstream ss;
-    msg = (string*) (serverConds[conditionIndex].waitQueue->Remove());//Hung: add myself to Condition Variable waitQueue
-    ss << *msg;
-    ss >> pktHdr.from;
-    ss >> mailHdr.from;
-    ss >> mailHdr.to;
+    // we remove the waiter from the queue and use it to acquire the lock after being signaled
+    ServerWaiter* waiter = removeWaiter(serverConds[conditionIndex].waitQueue);
+    pktHdr.from = waiter->machineId;
+    mailHdr.from = waiter->mailboxNum;
+    mailHdr.to = waiter->serverMailbox;
+    freeWaiter(waiter);
     //cout << "here?\n" << pktHdr.from << ' ' << mailHdr.from << ' ' << mailHdr.to << endl;
     Acquire_server(lockIndex, pktHdr, mailHdr);
     pktHdr.from = tempPktTo;
@@ -735,47 +1384,98 @@ void Signal_server(int lockIndex, int conditionIndex, PacketHeader &pktHdr, Mail
 
     sendMessageToClient("Signalled", pktHdr, mailHdr);
   }
-  if(serverConds[conditionIndex].waitQueue->IsEmpty()){
+  if(waiterQueueIsEmpty(serverConds[conditionIndex].waitQueue)){
     serverConds[conditionIndex].hasWaitingLock == FALSE; //reset if is empty
     serverConds[conditionIndex].waitingLockIndex == -1;
   }
 }
 
-// helper function to signal without postoffice functions
-void Signal_without_send(int lockIndex, int conditionIndex, PacketHeader &pktHdr, MailHeader &mailHdr) {
-  int tempPktTo = pktHdr.from;
-  int tempMailTo = mailHdr.from;
-  int tempMailFrom = mailHdr.to;
+// wait on one of our conditions with a lock that is on another server: the waiter is queued here,
+// and the lock's server releases the lock for it
+void WaitRemoteLock_server(int lockIndex, int conditionIndex, PacketHeader &pktHdr, MailHeader &mailHdr) {
   if(!validateConditionIndex(conditionIndex)) {
     sendMessageToClient("Invalid cond index!", pktHdr, mailHdr);
-  }else if(serverConds[conditionIndex].waitQueue->IsEmpty()) //no thread waiting
-  {
-    sendMessageToClient("No thread waiting!", pktHdr, mailHdr);
-  } else {
-    string* msg;
-    stringstream ss;
-    msg = (string*) (serverConds[conditionIndex].waitQueue->Remove());//Hung: add myself to Condition Variable waitQueue
-    ss << *msg;
-    ss >> pktHdr.from;
-    ss >> mailHdr.from;
-    ss >> mailHdr.to;
-    //cout << "here?\n" << pktHdr.from << ' ' << mailHdr.from << ' ' << mailHdr.to << endl;
-    Acquire_server(lockIndex, pktHdr, mailHdr);
-    pktHdr.from = tempPktTo;
-    mailHdr.from = tempMailTo;
-    mailHdr.to = tempMailFrom;
-    mailHdr.length = 9;
-    //cout << "here?\n" << pktHdr.to << ' ' << mailHdr.to << ' ' << mailHdr.from << endl;
+    return;
+  }
+  if (serverConds[conditionIndex].deleteFlag){
+    sendMessageToClient("Cond will be destroyed, can't wait!", pktHdr, mailHdr);
+    return;
+  }
+  if(!waiterQueueIsEmpty(serverConds[conditionIndex].waitQueue) && serverConds[conditionIndex].remoteLockIndex != lockIndex) {
+    sendMessageToClient("No permission to wait!", pktHdr, mailHdr);
+    return;
+  }
+  serverConds[conditionIndex].remoteLockIndex = lockIndex;
+  putMsgCond(pktHdr, mailHdr, "Finished Waiting!", conditionIndex);
+  sendLockRequestFor('r', lockIndex, pktHdr.from, mailHdr.from);
+}
 
+// signal (or, if "all", broadcast) one of our conditions whose waiters use a lock on another
+// server: the waiters woken are handed to the lock's server to reacquire the lock, which replies to
+// them.  a broadcast sends one request per client machine for all of its waiters
+void SignalRemoteLock_server(int lockIndex, int conditionIndex, bool all, PacketHeader &pktHdr, MailHeader &mailHdr) {
+  if(!validateConditionIndex(conditionIndex)) {
+    sendMessageToClient("Invalid cond index!", pktHdr, mailHdr);
+    return;
   }
-  if(serverConds[conditionIndex].waitQueue->IsEmpty()){
-    serverConds[conditionIndex].hasWaitingLock == FALSE;
-    serverConds[conditionIndex].waitingLockIndex == -1;
+  if(waiterQueueIsEmpty(serverConds[conditionIndex].waitQueue)) { //no thread waiting
+    if(all) {
+      sendMessageToClient("Broadcasted!", pktHdr, mailHdr);
+    } else {
+      sendMessageToClient("No thread waiting!", pktHdr, mailHdr);
+    }
+    return;
+  }
+  if(serverConds[conditionIndex].remoteLockIndex != lockIndex) {
+    sendMessageToClient("No permission to signal!", pktHdr, mailHdr);
+    return;
   }
+  if(all) {
+    ServerWaiter* groups[MaxNetworkPeers];
+    int order[MaxNetworkPeers];
+    int machines = groupWaitersByMachine(serverConds[conditionIndex].waitQueue, groups, order);
+    for(int i = 0; i < machines; ++i) {
+      sendGroupLockRequestFor(lockIndex, groups[order[i]]);
+    }
+  } else {
+    ServerWaiter* waiter = removeWaiter(serverConds[conditionIndex].waitQueue);
+    sendLockRequestFor('a', lockIndex, waiter->machineId, waiter->mailboxNum);
+    freeWaiter(waiter);
+  }
+  if(all) {
+    sendMessageToClient("Broadcasted!", pktHdr, mailHdr);
+  } else {
+    sendMessageToClient("Signalled", pktHdr, mailHdr);
+  }
+}
+
+// a client asks to wait on (op 'W') or signal ('S', 'B') one of our conditions with a lock that is
+// on another server.  that server checks the client holds the lock first ("L o"), and sends the
+// request back ("C V") for WaitRemoteLock_server or SignalRemoteLock_server
+void checkRemoteLockOwner(char op, int lockIndex, int conditionIndex, PacketHeader &pktHdr, MailHeader &mailHdr) {
+  if(!validateConditionIndex(conditionIndex)) {
+    sendMessageToClient("Invalid cond index!", pktHdr, mailHdr);
+    return;
+  }
+  stringstream ss;
+  ss << "L o " << lockIndex << ' ' << globalIndex(conditionIndex) << ' ' << op << ' ' << pktHdr.from << ' ' << mailHdr.from;
+  sendToServerOf(lockIndex, ss.str());
 }
 
+// carry out a request checkRemoteLockOwner sent to the lock's server, which has found that the client
+// thread holds the lock.  the headers are those of that server's message, so we put the client in them
+void RemoteLockChecked_server(int lockIndex, int conditionIndex, char op, int machineId, int mailboxNum, PacketHeader &pktHdr, MailHeader &mailHdr) {
+  pktHdr.from = machineId;
+  mailHdr.from = mailboxNum;
+  if(op == 'W') {
+    WaitRemoteLock_server(lockIndex, conditionIndex, pktHdr, mailHdr);
+  } else {
+    SignalRemoteLock_server(lockIndex, conditionIndex, op == 'B', pktHdr, mailHdr);
+  }
+}
 
-// broadcast condition server call
+// broadcast condition server call.  the waiters are queued for the lock one client machine at a
+// time, so each machine gets one message for all of its threads (see appendWakeGroup)
 void Broadcast_server(int lockIndex, int conditionIndex, PacketHeader &pktHdr, MailHeader &mailHdr) {
   ServerThread thread;
   thread.machineId = pktHdr.from;
@@ -793,12 +1493,11 @@ void Broadcast_server(int lockIndex, int conditionIndex, PacketHeader &pktHdr, M
   }else if(!(*waitingLock == conditionLock)) {
     sendMessageToClient("No permission to broadcast!", pktHdr, mailHdr);
   }else{
-    string* msg;
-    int stringIndex;
-    stringstream ss;
-    while(!serverConds[conditionIndex].waitQueue->IsEmpty()) //waitQueue is not empty
-    {
-      Signal_without_send(lockIndex, conditionIndex, pktHdr, mailHdr);
+    ServerWaiter* groups[MaxNetworkPeers];
+    int order[MaxNetworkPeers];
+    int machines = groupWaitersByMachine(serverConds[conditionIndex].waitQueue, groups, order);
+    for(int i = 0; i < machines; ++i) {
+      appendWakeGroup(lockIndex, groups[order[i]]);
     }
     serverConds[conditionIndex].hasWaitingLock == FALSE;
     serverConds[conditionIndex].waitingLockIndex = -1;
@@ -817,9 +1516,8 @@ void DestroyCondition_server(int conditionIndex, PacketHeader &pktHdr, MailHeade
       return;
   }
   // can be destroyed
-  if (serverConds[conditionIndex].waitQueue->IsEmpty()){
+  if (waiterQueueIsEmpty(serverConds[conditionIndex].waitQueue)){
     serverConds[conditionIndex].isDeleted = TRUE;
-    delete serverConds[conditionIndex].waitQueue;
     sendMessageToClient("Condition is destroyed.", pktHdr, mailHdr);
   }else {
     serverConds[conditionIndex].deleteFlag = TRUE;
@@ -838,32 +1536,304 @@ void DestroyCondition_server(int conditionIndex, PacketHeader &pktHdr, MailHeade
 // GetMonitor:       "M G 32"
 // SetMonitor:       "M S 2"
 // DestroyMonitor:   "M D 21"
+// GetMonitorRange:  "M R 3 0 20"          (monitor, first, count)
+// SetMonitorRange:  "M W 3 0 20 v0 ... v19"
+// CompareAndSwap:   "M X 3 5 0 1"         (monitor, index, expected, new value)
+// FetchAndAdd:      "M F 3 5 1"           (monitor, index, amount)
 
 // CreateCondition:  "C C name"
 // Wait:             "C W 32 2"
 // Signal:           "C S 2 46"
 // Broadcast:        "C B 21 36"
 // DestroyCondition: "C D 21"
-// Server polling and sending messages
-void Server() {
+
+// handle one request from a client.  called by the server worker that owns the
+// request's entity, or by the dispatcher for creates (which look up names across
+// all the entities) and when there are no workers
+void handleServerRequest(PacketHeader &pktHdr, MailHeader &mailHdr, char* buffer) {
+    char sysCode1, sysCode2;
+    stringstream ss;
+    char name[MaxMessageSize];
+
+    //Parse the message
+    int entityId = -1;
+    int entityIndex1 = -1;
+    int entityIndex2 = -1;
+    int entityIndex3 = -1;
+    int entityIndex4 = -1;
+    char op = ' ';
+    ss << buffer;
+    ss >> sysCode1 >> sysCode2;
+    if(sysCode2 == 'C') {
+        ss >> name;
+        cout << name << endl;
+    } else {
+        ss >> entityIndex1;
+    }
+    // big switch statement to determine syscalls
+    switch(sysCode1) {
+        case 'L': // lock server calls
+            switch(sysCode2) {
+                case 'C': // create lock
+                    cout << "Got to CreateLock_server" << endl;
+                    ss.str("");
+                    ss.clear();
+                    entityId = CreateLock_server(name, serverLockCount, pktHdr, mailHdr);
+                    ss << globalIndex(entityId);
+                    //cout << "CreateLock_server::entityId: " << entityId << endl;
+                    //Process the message
+                    sendCreateEntityMessage(ss, pktHdr, mailHdr);
+                break;
+                case 'A': // acquire lock
+                    // only send reply when they can Acquire
+                    cout << "Got to Acquire_server" << endl;
+                    Acquire_server(localIndex(entityIndex1), pktHdr, mailHdr);
+                    ss.str("");
+                    ss.clear();
+                    ss << "Acquire_server";
+                break;
+                case 'R': // release lock
+                    Release_server(localIndex(entityIndex1), pktHdr, mailHdr);
+                    ss.str("");
+                    ss.clear();
+                    ss << "Release_server";
+                break;
+                case 'D': // destroy lock
+                    DestroyLock_server(localIndex(entityIndex1), pktHdr, mailHdr);
+                    ss.str("");
+                    ss.clear();
+                    ss << "DestroyLock_server";
+                break;
+                case 'G': // acquire lock for a client machine's lock cache
+                    AcquireCached_server(entityIndex1, pktHdr, mailHdr);
+                    ss.str("");
+                    ss.clear();
+                break;
+                case 'H': // hand a cached lock over to the client thread holding it
+                    HandOver_server(localIndex(entityIndex1), pktHdr, mailHdr);
+                    ss.str("");
+                    ss.clear();
+                break;
+                case 'a': // acquire lock for a waiter on another server's condition
+                    ss >> entityIndex2;
+                    ss >> entityIndex3;
+                    AcquireFor_server(localIndex(entityIndex1), entityIndex2, entityIndex3, pktHdr, mailHdr);
+                    ss.str("");
+                    ss.clear();
+                break;
+                case 'b': // acquire lock for a group of waiters on another server's condition
+                    ss >> entityIndex2;
+                    AcquireGroupFor_server(localIndex(entityIndex1), entityIndex2, ss, pktHdr, mailHdr);
+                    ss.str("");
+                    ss.clear();
+                break;
+                case 'r': // release lock for a waiter on another server's condition
+                    ss >> entityIndex2;
+                    ss >> entityIndex3;
+                    ReleaseFor_server(localIndex(entityIndex1), entityIndex2, entityIndex3, pktHdr, mailHdr);
+                    ss.str("");
+                    ss.clear();
+                break;
+                case 'o': // check a client holds the lock before it waits on or signals another server's condition
+                    ss >> entityIndex2 >> op >> entityIndex3 >> entityIndex4;
+                    CheckOwnerFor_server(localIndex(entityIndex1), entityIndex2, op, entityIndex3, entityIndex4, pktHdr, mailHdr);
+                    ss.str("");
+                    ss.clear();
+                break;
+            }
+        break;
+        case 'M': // monitor server calls
+            switch(sysCode2) {
+                case 'C': // create monitor
+                    ss >> entityIndex1;
+                    ss.str("");
+                    ss.clear();
+                    entityId = CreateMonitor_server(name, entityIndex1, pktHdr, mailHdr);
+                    ss << globalIndex(entityId);
+                    //cout << "CreateMonitor_server::entityId: " << entityId << endl;
+                    sendCreateEntityMessage(ss, pktHdr, mailHdr);
+                break;
+                case 'G': // get monitor
+                    ss >> entityIndex2;
+                    ss >> entityIndex3;
+                    ss.str("");
+                    ss.clear();
+                    entityId = GetMonitor_server(localIndex(entityIndex1), entityIndex2,pktHdr, mailHdr);
+                break;
+                case 'S': // set monitor
+                ss >> entityIndex2;
+                ss >> entityIndex3;
+                    SetMonitor_server(localIndex(entityIndex1), entityIndex2,entityIndex3,pktHdr, mailHdr);
+                    ss.str("");
+                    ss.clear();
+                    ss << "SetMonitor_server";
+                break;
+                case 'L': // get monitor with a lease
+                    ss >> entityIndex2;
+                    ss >> entityIndex3;
+                    ss.str("");
+                    ss.clear();
+                    entityId = LeaseMonitor_server(localIndex(entityIndex1), entityIndex2, entityIndex3, pktHdr, mailHdr);
+                break;
+                case 'R': // get a range of monitor values
+                    ss >> entityIndex2;
+                    ss >> entityIndex3;
+                    GetMonitorRange_server(localIndex(entityIndex1), entityIndex2, entityIndex3, pktHdr, mailHdr);
+                    ss.str("");
+                    ss.clear();
+                    ss << "GetMonitorRange_server";
+                break;
+                case 'W': // set a range of monitor values
+                    ss >> entityIndex2;
+                    ss >> entityIndex3;
+                    SetMonitorRange_server(localIndex(entityIndex1), entityIndex2, entityIndex3, ss, pktHdr, mailHdr);
+                    ss.str("");
+                    ss.clear();
+                    ss << "SetMonitorRange_server";
+                break;
+                case 'X': // compare and swap monitor
+                    ss >> entityIndex2;
+                    ss >> entityIndex3;
+                    ss >> entityIndex4;
+                    entityId = CompareAndSwapMonitor_server(localIndex(entityIndex1), entityIndex2, entityIndex3, entityIndex4, pktHdr, mailHdr);
+                    ss.str("");
+                    ss.clear();
+                break;
+                case 'F': // fetch and add monitor
+                    ss >> entityIndex2;
+                    ss >> entityIndex3;
+                    entityId = FetchAndAddMonitor_server(localIndex(entityIndex1), entityIndex2, entityIndex3, pktHdr, mailHdr);
+                    ss.str("");
+                    ss.clear();
+                break;
+                case 'D': // destroy monitor
+                    DestroyMonitor_server(localIndex(entityIndex1), pktHdr, mailHdr);
+                    ss.str("");
+                    ss.clear();
+                    ss << "DestroyMonitor_server";
+                break;
+            }
+        break;
+        case 'C': // condition server calls
+            switch(sysCode2) {
+                case 'C': // create condition
+                    ss.str("");
+                    ss.clear();
+                    entityId = CreateCondition_server(name, serverCondCount, pktHdr, mailHdr);
+                    ss << globalIndex(entityId);
+                    //cout << "CreateCondition_server::entityId: " << entityId << endl;
+                    sendCreateEntityMessage(ss, pktHdr, mailHdr);
+                break;
+                case 'W': // condition wait
+                    ss >> entityIndex2;
+                    lockServerCond(localIndex(entityIndex2));
+                    if(isLocalIndex(entityIndex1)) {
+                        Wait_server(localIndex(entityIndex1), localIndex(entityIndex2), pktHdr, mailHdr); //lock then CV
+                    } else {
+                        checkRemoteLockOwner('W', entityIndex1, localIndex(entityIndex2), pktHdr, mailHdr);
+                    }
+                    unlockServerCond(localIndex(entityIndex2));
+                    ss.str("");
+                    ss.clear();
+                    ss << "Wait_server";
+                break;
+                case 'S': // condition signal
+                    ss >> entityIndex2;
+                    lockServerCond(localIndex(entityIndex2));
+                    if(isLocalIndex(entityIndex1)) {
+                        Signal_server(localIndex(entityIndex1), localIndex(entityIndex2), pktHdr, mailHdr); //lock then CV
+                    } else {
+                        checkRemoteLockOwner('S', entityIndex1, localIndex(entityIndex2), pktHdr, mailHdr);
+                    }
+                    unlockServerCond(localIndex(entityIndex2));
+
+                    ss.str("");
+                    ss.clear();
+                    ss << "Signal_server";
+                break;
+                case 'B': // create broadcast
+                    ss >> entityIndex2;
+                    lockServerCond(localIndex(entityIndex2));
+                    if(isLocalIndex(entityIndex1)) {
+                        Broadcast_server(localIndex(entityIndex1), localIndex(entityIndex2), pktHdr, mailHdr); //lock then CV
+                    } else {
+                        checkRemoteLockOwner('B', entityIndex1, localIndex(entityIndex2), pktHdr, mailHdr);
+                    }
+                    unlockServerCond(localIndex(entityIndex2));
+                    ss.str("");
+                    ss.clear();
+                    ss << "Broadcast_server";
+                break;
+                case 'V': // wait on or signal a condition, now that the lock's server has checked the client holds it
+                    ss >> entityIndex2 >> op >> entityIndex3 >> entityIndex4;
+                    lockServerCond(localIndex(entityIndex2));
+                    RemoteLockChecked_server(entityIndex1, localIndex(entityIndex2), op, entityIndex3, entityIndex4, pktHdr, mailHdr);
+                    unlockServerCond(localIndex(entityIndex2));
+                    ss.str("");
+                    ss.clear();
+                break;
+                case 'D': // destroy condition
+                    lockServerCond(localIndex(entityIndex1));
+                    DestroyCondition_server(localIndex(entityIndex1), pktHdr, mailHdr);
+                    unlockServerCond(localIndex(entityIndex1));
+                    ss.str("");
+                    ss.clear();
+                    ss << "DestroyCondition_server";
+                break;
+            }
+        break;
+    }
+}
+
+// a server worker: handles the requests for its shard of the locks, conditions and
+// monitors, which the dispatcher puts in the worker's own mailbox (shard + 1).  a
+// worker that is held up sending to a slow client doesn't hold up the other shards
+void ServerWorker(int shard) {
+    PacketHeader pktHdr;
+    MailHeader mailHdr;
+    char buffer[MaxMessageSize];
+
+    while(true) {
+        postOffice->Receive(shard + 1, &pktHdr, &mailHdr, buffer);
+        handleServerRequest(pktHdr, mailHdr, buffer);
+    }
+}
+
+// Server polling and sending messages.  this thread is the dispatcher: it takes every
+// request from mailbox 0 and hands it to the worker that owns the entity it is about,
+// by the first entity index in the request (the lock for condition operations, so a
+// condition's waiters and its lock are in the same shard; see serverCondLocks).
+// with several servers, this one is server "machineId" and has the entities whose
+// index % numServers is machineId (the clients send each request to the right one)
+void Server(int machineId) {
     cout << "Server()" << endl;
+    ASSERT(machineId >= 0 && machineId < numServers); // the servers are machines 0 to numServers - 1
+    serverIndex = machineId;
     stringArr[0] = "You got the lock!";
     stringArr[1] = "Finished Waiting!";
+    stringArr[2] = LockCacheGrant; // a lock granted to a client machine's lock cache, followed by its index
+    stringArr[3] = LockCacheGroupGrant; // ... granted for a group of its threads a Broadcast woke, followed by their mailboxes
 
-    char sysCode1, sysCode2;
     for (int i = 0; i <MAX_MON_COUNT; ++i){
-      serverLocks[i].waitQueue = new List();
-      serverConds[i].waitQueue = new List();
+      initWaiterQueue(serverLocks[i].waitQueue);
+      initWaiterQueue(serverConds[i].waitQueue);
       serverConds[i].hasWaitingLock = FALSE;
+      serverConds[i].remoteLockIndex = -1;
+      serverCondLocks[i] = new Lock("server condition");
       serverLocks[i].lockStatus = serverLocks[i].FREE;
     }
+    ASSERT(numServerWorkers >= 0 && numServerWorkers < NumMailboxes);
+    for (int i = 0; i < numServerWorkers; ++i) {
+      replyMailboxMap->Mark(i + 1); // the workers' mailboxes are not reply mailboxes
+      replyMailboxesFree->P();
+      Thread* worker = new Thread("server worker");
+      worker->Fork(ServerWorker, i);
+    }
     PacketHeader pktHdr; // Pkt is hardware level // just need to know the machine->Id at command line
     MailHeader mailHdr; // Mail
-    char buffer[MaxMailSize];
+    char buffer[MaxMessageSize];
     stringstream ss;
 
-    char name[60];
-
     while(true) {
         //Recieve the message
         ss.str("");
@@ -872,129 +1842,21 @@ void Server() {
         postOffice->Receive(0, &pktHdr, &mailHdr, buffer);
         //printf("Got \"%s\" from %d, box %d\n",buffer,pktHdr.from,mailHdr.from);
         fflush(stdout);
-        //Parse the message
-        int entityId = -1;
-        int entityIndex1 = -1;
-        int entityIndex2 = -1;
-        int entityIndex3 = -1;
+        if(pktHdr.from < 0 || pktHdr.from >= MaxNetworkPeers) { // waiters and leases are kept per machine
+            printf("Server: ignoring a request from machine %d, ids must be below %d\n", pktHdr.from, MaxNetworkPeers);
+            continue;
+        }
+        char sysCode1 = ' ', sysCode2 = ' ';
+        int entityIndex1 = 0;
         ss << buffer;
         ss >> sysCode1 >> sysCode2;
-        if(sysCode2 == 'C') {
-            ss >> name;
-            cout << name << endl;
-        } else {
-            ss >> entityIndex1;
-        }
-        // big switch statement to determine syscalls
-        switch(sysCode1) {
-            case 'L': // lock server calls
-                switch(sysCode2) {
-                    case 'C': // create lock
-                        cout << "Got to CreateLock_server" << endl;
-                        ss.str("");
-                        ss.clear();
-                        entityId = CreateLock_server(name, serverLockCount, pktHdr, mailHdr);
-                        ss << entityId;
-                        //cout << "CreateLock_server::entityId: " << entityId << endl;
-                        //Process the message
-                        sendCreateEntityMessage(ss, pktHdr, mailHdr);
-                    break;
-                    case 'A': // acquire lock
-                        // only send reply when they can Acquire
-                        cout << "Got to Acquire_server" << endl;
-                        Acquire_server(entityIndex1, pktHdr, mailHdr);
-                        ss.str("");
-                        ss.clear();
-                        ss << "Acquire_server";
-                    break;
-                    case 'R': // release lock
-                        Release_server(entityIndex1, pktHdr, mailHdr);
-                        ss.str("");
-                        ss.clear();
-                        ss << "Release_server";
-                    break;
-                    case 'D': // destroy lock
-                        DestroyLock_server(entityIndex1, pktHdr, mailHdr);
-                        ss.str("");
-                        ss.clear();
-                        ss << "DestroyLock_server";
-                    break;
-                }
-            break;
-            case 'M': // monitor server calls
-                switch(sysCode2) {
-                    case 'C': // create monitor
-                        ss >> entityIndex1;
-                        ss.str("");
-                        ss.clear();
-                        entityId = CreateMonitor_server(name, entityIndex1, pktHdr, mailHdr);
-                        ss << entityId;
-                        //cout << "CreateMonitor_server::entityId: " << entityId << endl;
-                        sendCreateEntityMessage(ss, pktHdr, mailHdr);
-                    break;
-                    case 'G': // get monitor
-                        ss >> entityIndex2;
-                        ss >> entityIndex3;
-                        ss.str("");
-                        ss.clear();
-                        entityId = GetMonitor_server(entityIndex1, entityIndex2,pktHdr, mailHdr);
-                    break;
-                    case 'S': // set monitor
-                    ss >> entityIndex2;
-                    ss >> entityIndex3;
-                        SetMonitor_server(entityIndex1, entityIndex2,entityIndex3,pktHdr, mailHdr);
-                        ss.str("");
-                        ss.clear();
-                        ss << "SetMonitor_server";
-                    break;
-                    case 'D': // destroy monitor
-                        DestroyMonitor_server(entityIndex1, pktHdr, mailHdr);
-                        ss.str("");
-                        ss.clear();
-                        ss << "DestroyMonitor_server";
-                    break;
-                }
-            break;
-            case 'C': // condition server calls
-                switch(sysCode2) {
-                    case 'C': // create condition
-                        ss.str("");
-                        ss.clear();
-                        entityId = CreateCondition_server(name, serverCondCount, pktHdr, mailHdr);
-                        ss << entityId;
-                        //cout << "CreateCondition_server::entityId: " << entityId << endl;
-                        sendCreateEntityMessage(ss, pktHdr, mailHdr);
-                    break;
-                    case 'W': // condition wait
-                        ss >> entityIndex2;
-                        Wait_server(entityIndex1, entityIndex2, pktHdr, mailHdr); //lock then CV
-                        ss.str("");
-                        ss.clear();
-                        ss << "Wait_server";
-                    break;
-                    case 'S': // condition signal
-                        ss >> entityIndex2;
-                        Signal_server(entityIndex1, entityIndex2, pktHdr, mailHdr); //lock then CV
-
-                        ss.str("");
-                        ss.clear();
-                        ss << "Signal_server";
-                    break;
-                    case 'B': // create broadcast
-                        ss >> entityIndex2;
-                        Broadcast_server(entityIndex1, entityIndex2, pktHdr, mailHdr); //lock then CV
-                        ss.str("");
-                        ss.clear();
-                        ss << "Broadcast_server";
-                    break;
-                    case 'D': // destroy condition
-                        DestroyCondition_server(entityIndex1, pktHdr, mailHdr);
-                        ss.str("");
-                        ss.clear();
-                        ss << "DestroyCondition_server";
-                    break;
-                }
-            break;
+        if(sysCode2 == 'C' || numServerWorkers == 0) {
+            handleServerRequest(pktHdr, mailHdr, buffer);
+            continue;
         }
+        ss >> entityIndex1;
+        int workerMailbox = 1 + (unsigned int) entityIndex1 / numServers % numServerWorkers;
+        mailHdr.to = workerMailbox;
+        postOffice->Deliver(workerMailbox, pktHdr, mailHdr, buffer);
     }
 }
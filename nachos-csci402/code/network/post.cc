@@ -9,6 +9,9 @@
 //	the combination (MailHdr plus data) looks like "data" to the Network
 //	device.
 //
+//	Messages too long for one packet are split into fragments by Send,
+//	and put back together by the receiving MailBox.
+//
 // 	The implementation synchronizes incoming messages with threads
 //	waiting for those messages.
 //
@@ -18,6 +21,8 @@
 
 #include "copyright.h"
 #include "post.h"
+#include "system.h"
+#include "sysdep.h"
 
 extern "C" {
 	int bcopy(char *, char *, int);
@@ -35,13 +40,67 @@ extern "C" {
 
 Mail::Mail(PacketHeader pktH, MailHeader mailH, char *msgData)
 {
-    ASSERT(mailH.length <= MaxMailSize);
+    ASSERT(mailH.length <= MaxMessageSize);
 
     pktHdr = pktH;
     mailHdr = mailH;
+    data = new char[mailHdr.length];
     bcopy(msgData, data, mailHdr.length);
+    fragments = 1;
+}
+
+Mail::~Mail()
+{
+    delete [] data;
+}
+
+//----------------------------------------------------------------------
+// Mail::Append
+//      Add the next fragment of a message that arrived in several
+//	packets to the end of its data.
+//
+//	"moreData" -- the fragment's data
+//	"length" -- how many bytes of it there are
+//----------------------------------------------------------------------
+
+void
+Mail::Append(char *moreData, int length)
+{
+    ASSERT(mailHdr.length + length <= MaxMessageSize);
+
+    char *longer = new char[mailHdr.length + length];
+    bcopy(data, longer, mailHdr.length);
+    bcopy(moreData, longer + mailHdr.length, length);
+    delete [] data;
+    data = longer;
+    mailHdr.length += length;
+    fragments++;
+}
+
+//----------------------------------------------------------------------
+// PeerState::PeerState
+//      Initialize what we know about another machine: nothing sent to it
+//	yet, and nothing heard from it.
+//----------------------------------------------------------------------
+
+PeerState::PeerState()
+{
+    nextSeq = 0;
+    numUnacked = 0;
+    knowsPeer = FALSE;
+    peerEpoch = 0;
+    expectedSeq = 0;
+    ackPending = FALSE;
+    waitingSince = 0;
+    down = FALSE;
 }
 
+// Is "item", a message being put back together, from the machine and
+// mail box in "arg" (machine * 256 + mail box)?
+static bool FromSender(void *item, int arg)
+{ Mail *mail = (Mail *) item;
+  return mail->pktHdr.from * 256 + mail->mailHdr.from == arg; }
+
 //----------------------------------------------------------------------
 // MailBox::MailBox
 //      Initialize a single mail box within the post office, so that it
@@ -54,6 +113,7 @@ Mail::Mail(PacketHeader pktH, MailHeader mailH, char *msgData)
 MailBox::MailBox()
 {
     messages = new SynchList();
+    partial = new List();
 }
 
 //----------------------------------------------------------------------
@@ -67,6 +127,9 @@ MailBox::MailBox()
 MailBox::~MailBox()
 {
     delete messages;
+    while (!partial->IsEmpty())
+	delete (Mail *) partial->Remove();
+    delete partial;
 }
 
 //----------------------------------------------------------------------
@@ -108,6 +171,45 @@ MailBox::Put(PacketHeader pktHdr, MailHeader mailHdr, char *data)
 					// any waiters
 }
 
+//----------------------------------------------------------------------
+// MailBox::PutFragment
+// 	Add a fragment of a long message to the rest of it.  Once the last
+//	fragment is in, the message goes in the mailbox like any other.
+//	Only the postal worker calls this, so "partial" needs no lock.
+//
+//	If a fragment goes missing (only without the reliable transport),
+//	the whole message is thrown away.
+//
+//	"pktHdr" -- source, destination machine ID's
+//	"mailHdr" -- source, destination mailbox ID's; length of the fragment
+//	"data" -- the fragment's data
+//	"index" -- which fragment of the message this is (0 for the first),
+//		or -1 if it is known to be the next one
+//	"more" -- are there more fragments to come?
+//----------------------------------------------------------------------
+
+void
+MailBox::PutFragment(PacketHeader pktHdr, MailHeader mailHdr, char *data,
+		     int index, bool more)
+{
+    Mail *mail = (Mail *) partial->RemoveFirstMatch(FromSender,
+					pktHdr.from * 256 + mailHdr.from);
+
+    if (index == 0) {			// start of a new message; if the
+	delete mail;			// last one never ended, forget it
+	mail = new Mail(pktHdr, mailHdr, data);
+    } else if (mail == NULL || (index > 0 && index != mail->fragments)) {
+	delete mail;			// we missed a fragment
+	return;
+    } else
+	mail->Append(data, mailHdr.length);
+
+    if (more)
+	partial->Append((void *)mail);
+    else
+	messages->Append((void *)mail);	// complete: wake up any waiters
+}
+
 //----------------------------------------------------------------------
 // MailBox::Get
 // 	Get a message from a mailbox, parsing it into the packet header,
@@ -155,6 +257,17 @@ static void ReadAvail(int arg)
 { PostOffice* po = (PostOffice *) arg; po->IncomingPacket(); }
 static void WriteDone(int arg)
 { PostOffice* po = (PostOffice *) arg; po->PacketSent(); }
+static void TransportHelper(int arg)
+{ PostOffice* po = (PostOffice *) arg; po->TransportWork(); }
+static void RetransmitTimerHandler(int arg)
+{ PostOffice* po = (PostOffice *) arg; po->RetransmitTimerExpired(); }
+static void AckTimerHandler(int arg)
+{ PostOffice* po = (PostOffice *) arg; po->AckTimerExpired(); }
+
+// Is sequence number "a" before "b"?  They wrap around, but the two
+// ends of a window are never more than SendWindow apart.
+static bool SeqBefore(unsigned short a, unsigned short b)
+{ return (short) (a - b) < 0; }
 
 //----------------------------------------------------------------------
 // PostOffice::PostOffice
@@ -173,6 +286,10 @@ static void WriteDone(int arg)
 //	  drops any packets; reliability = 0 means the network never
 //	  delivers any packets)
 //	"nBoxes" is the number of mail boxes in this Post Office
+//
+//	With the reliable transport, a second thread "the transport
+//	worker" sends the acknowledgements and retransmissions when the
+//	transport's timers go off.
 //----------------------------------------------------------------------
 
 PostOffice::PostOffice(NetworkAddress addr, double reliability, int nBoxes)
@@ -181,11 +298,24 @@ PostOffice::PostOffice(NetworkAddress addr, double reliability, int nBoxes)
     messageAvailable = new Semaphore("message available", 0);
     messageSent = new Semaphore("message sent", 0);
     sendLock = new Lock("message send lock");
+    fragmentLock = new Lock("message fragment lock");
 
 // Second, initialize the mailboxes
     netAddr = addr;
     numBoxes = nBoxes;
     boxes = new MailBox[nBoxes];
+    ASSERT(nBoxes <= 256);		// mail box numbers are bytes on the wire
+    ASSERT(sizeof(WireHeader) <= sizeof(MailHeader));
+
+// ... and the reliable transport.  Sequence numbers start over at 0 each
+//   time Nachos runs; the epoch lets the other machines tell the runs apart.
+    reliable = useReliableTransport;
+    epoch = (unsigned short) ((long long) (HostSeconds() * 1000) & 0xffff);
+    peers = new PeerState[MaxNetworkPeers];
+    transportLock = new Lock("transport lock");
+    acksArrived = new Condition("acks arrived");
+    transportWork = new Semaphore("transport work", 0);
+    retransmitDue = ackDue = FALSE;
 
 // Third, initialize the network; tell it which interrupt handlers to call
     network = new Network(addr, reliability, ReadAvail, WriteDone, (int) this);
@@ -196,6 +326,11 @@ PostOffice::PostOffice(NetworkAddress addr, double reliability, int nBoxes)
     Thread *t = new Thread("postal worker");
 
     t->Fork(PostalHelper, (int) this);
+
+    if (reliable) {
+	t = new Thread("transport worker");
+	t->Fork(TransportHelper, (int) this);
+    }
 }
 
 //----------------------------------------------------------------------
@@ -210,6 +345,11 @@ PostOffice::~PostOffice()
     delete messageAvailable;
     delete messageSent;
     delete sendLock;
+    delete fragmentLock;
+    delete [] peers;
+    delete transportLock;
+    delete acksArrived;
+    delete transportWork;
 }
 
 //----------------------------------------------------------------------
@@ -217,7 +357,10 @@ PostOffice::~PostOffice()
 // 	Wait for incoming messages, and put them in the right mailbox.
 //
 //      Incoming messages have had the PacketHeader stripped off,
-//	but the MailHeader is still tacked on the front of the data.
+//	but the WireHeader is still tacked on the front of the data.
+//	With the reliable transport, we take note of any acknowledgement
+//	in it, and drop the message if it is not the next one in sequence.
+//	Fragments of a longer message go to the mailbox to be put together.
 //----------------------------------------------------------------------
 
 void
@@ -225,6 +368,7 @@ PostOffice::PostalDelivery()
 {
     PacketHeader pktHdr;
     MailHeader mailHdr;
+    WireHeader wire;
     char *buffer = new char[MaxPacketSize];
 
     for (;;) {
@@ -232,7 +376,10 @@ PostOffice::PostalDelivery()
         messageAvailable->P();
         pktHdr = network->Receive(buffer);
 
-        mailHdr = *(MailHeader *)buffer;
+        wire = *(WireHeader *)buffer;
+        mailHdr.to = wire.to;
+        mailHdr.from = wire.from;
+        mailHdr.length = wire.length;
         if (DebugIsEnabled('n')) {
 	    printf("Putting mail into mailbox: ");
 	    PrintHeader(pktHdr, mailHdr);
@@ -242,9 +389,108 @@ PostOffice::PostalDelivery()
 	ASSERT(0 <= mailHdr.to && mailHdr.to < numBoxes);
 	ASSERT(mailHdr.length <= MaxMailSize);
 
+	if (wire.flags & (WireData | WireAck)) { // sent reliably
+	    ASSERT(0 <= pktHdr.from && pktHdr.from < MaxNetworkPeers);
+	    transportLock->Acquire();
+	    PeerState *peer = &peers[pktHdr.from];
+	    if (wire.flags & WireAck)
+		Acknowledged(peer, &wire);
+	    bool deliver = (wire.flags & WireData) && Accept(peer, &wire);
+	    transportLock->Release();
+	    if (!deliver)
+		continue;
+	}
+
 	// put into mailbox
-        boxes[mailHdr.to].Put(pktHdr, mailHdr, buffer + sizeof(MailHeader));
+	if (!(wire.flags & (WireMore | WireContinued)))
+	    boxes[mailHdr.to].Put(pktHdr, mailHdr, buffer + sizeof(WireHeader));
+	else {
+	    int index;			// which fragment is it?
+	    if (!(wire.flags & WireContinued))
+		index = 0;
+	    else if (wire.flags & WireData)
+		index = -1;		// in sequence, so the next one
+	    else
+		index = wire.seq;
+	    boxes[mailHdr.to].PutFragment(pktHdr, mailHdr,
+			buffer + sizeof(WireHeader), index,
+			(wire.flags & WireMore) != 0);
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// PostOffice::Acknowledged
+// 	Forget the messages to "peer" that an arriving packet acknowledges,
+//	and wake up anyone waiting for room in the window.  Progress
+//	restarts the retransmission timer, so a message sent just before
+//	the ack is not resent early.  Called with the transport lock held.
+//----------------------------------------------------------------------
+
+void
+PostOffice::Acknowledged(PeerState *peer, WireHeader *wire)
+{
+    int acked = 0;
+
+    if (wire->ackEpoch != epoch)	// about an earlier run of ours
+	return;
+    while (peer->numUnacked > 0 &&
+	   SeqBefore((unsigned short) (peer->nextSeq - peer->numUnacked),
+		     wire->ack)) {
+	peer->numUnacked--;
+	acked++;
+    }
+    if (acked > 0) {
+	peer->waitingSince = HostSeconds();
+	ResetRetransmitTimer();
+	acksArrived->Broadcast(transportLock);
+    }
+}
+
+//----------------------------------------------------------------------
+// PostOffice::Accept
+// 	Decide whether a message that has arrived from "peer" should be
+//	delivered: only if it is the next one in sequence.  Either way we
+//	owe the peer an acknowledgement, which goes out on our next message
+//	to it, or after AckDelay ticks.  Called with the transport lock held.
+//
+//	A message from a run of the peer we have not heard from before
+//	starts its sequence over; if we missed that run's first message, we
+//	wait for it to be sent again.  A peer we gave up on is back once we
+//	hear from a new run of it.
+//----------------------------------------------------------------------
+
+bool
+PostOffice::Accept(PeerState *peer, WireHeader *wire)
+{
+    if (!peer->knowsPeer || wire->epoch != peer->peerEpoch) {
+	if (wire->seq != 0) {
+	    stats->numDuplicatesDropped++;
+	    return FALSE;
+	}
+	if (peer->knowsPeer) {		// the peer restarted: whatever we
+	    peer->nextSeq = 0;		// were sending its last run is lost
+	    peer->numUnacked = 0;
+	    ResetRetransmitTimer();
+	    acksArrived->Broadcast(transportLock);
+	}
+	peer->knowsPeer = TRUE;
+	peer->down = FALSE;
+	peer->peerEpoch = wire->epoch;
+	peer->expectedSeq = 0;
     }
+
+    peer->ackPending = TRUE;
+    if (!interrupt->IsPending(ackTimer))
+	ackTimer = interrupt->Schedule(AckTimerHandler, (int) this, AckDelay,
+				       NetworkTimerInt);
+
+    if (wire->seq != peer->expectedSeq) {	// a duplicate, or one after
+	stats->numDuplicatesDropped++;		// a lost message
+	return FALSE;
+    }
+    peer->expectedSeq++;
+    return TRUE;
 }
 
 //----------------------------------------------------------------------
@@ -255,6 +501,11 @@ PostOffice::PostalDelivery()
 //	Note that the MailHeader + data looks just like normal payload
 //	data to the Network.
 //
+//	A message longer than MaxMailSize goes as several fragments of
+//	MaxMailSize bytes (the last one shorter).  Only one such message
+//	is sent at a time, so that fragments of messages from the same
+//	mailbox don't get mixed up.
+//
 //	"pktHdr" -- source, destination machine ID's
 //	"mailHdr" -- source, destination mailbox ID's
 //	"data" -- payload message data
@@ -263,24 +514,126 @@ PostOffice::PostalDelivery()
 bool
 PostOffice::Send(PacketHeader pktHdr, MailHeader mailHdr, char* data)
 {
-    char* buffer = new char[MaxPacketSize];	// space to hold concatenated
-						// mailHdr + data
-
     if (DebugIsEnabled('n')) {
 	printf("Post send: ");
 	PrintHeader(pktHdr, mailHdr);
     }
 
-    ASSERT(mailHdr.length <= MaxMailSize);
+    ASSERT(mailHdr.length <= MaxMessageSize);
     ASSERT(0 <= mailHdr.to && mailHdr.to < numBoxes);
 
+    if (mailHdr.length <= MaxMailSize)
+	return SendFragment(pktHdr.to, mailHdr, data, 0, 0);
+
+    MailHeader fragHdr = mailHdr;
+    unsigned short index = 0;
+    bool success = TRUE;
+
+    fragmentLock->Acquire();
+    for (unsigned offset = 0; offset < mailHdr.length;
+	 offset += MaxMailSize, index++) {
+	fragHdr.length = min(mailHdr.length - offset, (unsigned) MaxMailSize);
+	int fragment = (index > 0) ? WireContinued : 0;
+	if (offset + fragHdr.length < mailHdr.length)
+	    fragment |= WireMore;
+	if (!SendFragment(pktHdr.to, fragHdr, data + offset, fragment, index))
+	    success = FALSE;
+    }
+    fragmentLock->Release();
+    return success;
+}
+
+//----------------------------------------------------------------------
+// PostOffice::SendFragment
+// 	Send one packet of a message to machine "to", with the reliable
+//	transport if it is on: wait for room in the window, and keep a copy
+//	of the packet until it is acknowledged.  Fails if we have given up
+//	on "to".
+//
+//	"mailHdr" -- source, destination mailbox ID's; length of the packet
+//	"data" -- its data
+//	"fragment" -- WireMore and/or WireContinued if it is part of a
+//		longer message, otherwise 0
+//	"index" -- which fragment of the message it is
+//----------------------------------------------------------------------
+
+bool
+PostOffice::SendFragment(NetworkAddress to, MailHeader mailHdr, char *data,
+			 int fragment, unsigned short index)
+{
+    if (!reliable)			// the fragment number goes in the
+	return SendPacket(to, mailHdr, data, fragment, index); // seq field
+
+    ASSERT(0 <= to && to < MaxNetworkPeers);
+    transportLock->Acquire();
+    PeerState *peer = &peers[to];
+    while (peer->numUnacked == SendWindow && !peer->down)
+	acksArrived->Wait(transportLock);	// wait for room in the window
+    if (peer->down) {
+	transportLock->Release();
+	return FALSE;
+    }
+
+    // keep a copy until it is acknowledged
+    int slot = peer->nextSeq % SendWindow;
+    peer->unackedHdr[slot] = mailHdr;
+    bcopy(data, peer->unackedData[slot], mailHdr.length);
+    peer->unackedFragment[slot] = fragment;
+    unsigned short seq = peer->nextSeq++;
+    if (peer->numUnacked++ == 0)
+	peer->waitingSince = HostSeconds();
+    StartRetransmitTimer();
+
+    bool success = SendPacket(to, mailHdr, data, WireData | fragment, seq);
+    transportLock->Release();
+    return success;
+}
+
+//----------------------------------------------------------------------
+// PostOffice::SendPacket
+// 	Put the WireHeader in front of the data, and pass the result to
+//	the Network for delivery to machine "to".  If we owe "to" an
+//	acknowledgement, it goes along.  With the reliable transport, the
+//	caller holds the transport lock.
+//
+//	"flags" -- WireData for a sequenced message, 0 for an unreliable
+//		one or a bare acknowledgement, plus WireMore and
+//		WireContinued for a fragment
+//	"seq" -- the message's sequence number (WireData), or the
+//		fragment number of an unreliable fragment
+//----------------------------------------------------------------------
+
+bool
+PostOffice::SendPacket(NetworkAddress to, MailHeader mailHdr, char *data,
+		       int flags, unsigned short seq)
+{
+    char buffer[MaxPacketSize];		// space to hold concatenated
+					// WireHeader + data
+    PacketHeader pktHdr;
+    WireHeader wire;
+
+    wire.to = mailHdr.to;
+    wire.from = mailHdr.from;
+    wire.length = mailHdr.length;
+    wire.flags = flags;
+    wire.seq = seq;
+    wire.epoch = epoch;
+    wire.ack = wire.ackEpoch = 0;
+    if (reliable && peers[to].knowsPeer) {	// acknowledge everything
+	wire.flags |= WireAck;			// we have from "to"
+	wire.ack = peers[to].expectedSeq;
+	wire.ackEpoch = peers[to].peerEpoch;
+	peers[to].ackPending = FALSE;
+    }
+
     // fill in pktHdr, for the Network layer
+    pktHdr.to = to;
     pktHdr.from = netAddr;
-    pktHdr.length = mailHdr.length + sizeof(MailHeader);
+    pktHdr.length = mailHdr.length + sizeof(WireHeader);
 
-    // concatenate MailHeader and data
-    bcopy((char *) &mailHdr, buffer, sizeof(MailHeader));
-    bcopy(data, buffer + sizeof(MailHeader), mailHdr.length);
+    // concatenate WireHeader and data
+    bcopy((char *) &wire, buffer, sizeof(WireHeader));
+    bcopy(data, buffer + sizeof(WireHeader), mailHdr.length);
 
     sendLock->Acquire();   		// only one message can be sent
 					// to the network at any one time
@@ -289,11 +642,150 @@ PostOffice::Send(PacketHeader pktHdr, MailHeader mailHdr, char* data)
 					// ok to send the next message
     sendLock->Release();
 
-    delete [] buffer;			// we've sent the message, so
-					// we can delete our buffer
     return success;
 }
 
+//----------------------------------------------------------------------
+// PostOffice::Flush
+// 	Wait until every message sent so far has been acknowledged (or
+//	its machine given up on), and send the acknowledgements we still
+//	owe, so that nothing is left undelivered when Nachos halts.
+//----------------------------------------------------------------------
+
+void
+PostOffice::Flush()
+{
+    MailHeader ackHdr;
+
+    if (!reliable)
+	return;
+    ackHdr.to = 0;
+    ackHdr.from = 0;
+    ackHdr.length = 0;
+    transportLock->Acquire();
+    for (int i = 0; i < MaxNetworkPeers; i++)
+	while (peers[i].numUnacked > 0)
+	    acksArrived->Wait(transportLock);
+    for (int i = 0; i < MaxNetworkPeers; i++)
+	if (peers[i].ackPending) {
+	    SendPacket(i, ackHdr, "", 0, 0);
+	    stats->numAcksSent++;
+	}
+    transportLock->Release();
+}
+
+//----------------------------------------------------------------------
+// PostOffice::StartRetransmitTimer
+// 	Make sure the retransmission timer is running.  Called with the
+//	transport lock held.
+//----------------------------------------------------------------------
+
+void
+PostOffice::StartRetransmitTimer()
+{
+    if (!interrupt->IsPending(retransmitTimer))
+	retransmitTimer = interrupt->Schedule(RetransmitTimerHandler,
+			(int) this, RetransmitTimeout, NetworkTimerInt);
+}
+
+//----------------------------------------------------------------------
+// PostOffice::ResetRetransmitTimer
+// 	Start the retransmission timer over, or stop it if no machine has
+//	messages of ours left to acknowledge.  Called with the transport
+//	lock held.
+//----------------------------------------------------------------------
+
+void
+PostOffice::ResetRetransmitTimer()
+{
+    interrupt->Cancel(retransmitTimer);
+    for (int i = 0; i < MaxNetworkPeers; i++)
+	if (peers[i].numUnacked > 0) {
+	    StartRetransmitTimer();
+	    return;
+	}
+}
+
+//----------------------------------------------------------------------
+// PostOffice::RetransmitTimerExpired, PostOffice::AckTimerExpired
+// 	Interrupt handlers for the transport's timers.  Sending takes
+//	locks, so the transport worker does the work.
+//----------------------------------------------------------------------
+
+void
+PostOffice::RetransmitTimerExpired()
+{
+    retransmitDue = TRUE;
+    transportWork->V();
+}
+
+void
+PostOffice::AckTimerExpired()
+{
+    ackDue = TRUE;
+    transportWork->V();
+}
+
+//----------------------------------------------------------------------
+// PostOffice::TransportWork
+// 	The transport worker.  When the ack timer goes off, send a bare
+//	acknowledgement to every machine we still owe one (no message to
+//	it came along to carry it).  When the retransmission timer goes
+//	off, send every unacknowledged message again, oldest first, and
+//	start the timer again if there were any; but give up on a machine
+//	that has not acknowledged anything for PeerTimeout seconds.
+//----------------------------------------------------------------------
+
+void
+PostOffice::TransportWork()
+{
+    MailHeader ackHdr;
+
+    ackHdr.to = 0;
+    ackHdr.from = 0;
+    ackHdr.length = 0;
+    for (;;) {
+	transportWork->P();
+	transportLock->Acquire();
+	if (ackDue) {
+	    ackDue = FALSE;
+	    for (int i = 0; i < MaxNetworkPeers; i++)
+		if (peers[i].ackPending) {
+		    SendPacket(i, ackHdr, "", 0, 0);
+		    stats->numAcksSent++;
+		}
+	}
+	if (retransmitDue) {
+	    retransmitDue = FALSE;
+	    bool waiting = FALSE;
+	    for (int i = 0; i < MaxNetworkPeers; i++) {
+		PeerState *peer = &peers[i];
+		if (peer->numUnacked > 0 &&
+		    HostSeconds() - peer->waitingSince > PeerTimeout) {
+		    printf("Machine %d is not answering: dropping %d "
+			   "messages to it\n", i, peer->numUnacked);
+		    peer->numUnacked = 0;
+		    peer->down = TRUE;
+		    acksArrived->Broadcast(transportLock);
+		    continue;
+		}
+		for (int k = peer->numUnacked; k > 0; k--) {
+		    unsigned short seq = peer->nextSeq - k;
+		    int slot = seq % SendWindow;
+		    SendPacket(i, peer->unackedHdr[slot],
+			       peer->unackedData[slot],
+			       WireData | peer->unackedFragment[slot], seq);
+		    stats->numRetransmissions++;
+		    waiting = TRUE;
+		}
+	    }
+	    if (waiting)
+		StartRetransmitTimer();
+	}
+	transportLock->Release();
+    }
+}
+
 //----------------------------------------------------------------------
 // PostOffice::Send
 // 	Retrieve a message from a specific box if one is available,
@@ -316,7 +808,29 @@ PostOffice::Receive(int box, PacketHeader *pktHdr,
     ASSERT((box >= 0) && (box < numBoxes));
 
     boxes[box].Get(pktHdr, mailHdr, data);
-    ASSERT(mailHdr->length <= MaxMailSize);
+    ASSERT(mailHdr->length <= MaxMessageSize);
+}
+
+//----------------------------------------------------------------------
+// PostOffice::Deliver
+// 	Put a message straight into one of our own mailboxes, keeping its
+//	return address, so that a thread that received it can pass it on
+//	to another thread on this machine to answer.
+//
+//	"box" -- mailbox ID to put the message in
+//	"pktHdr" -- source, destination machine ID's
+//	"mailHdr" -- source, destination mailbox ID's
+//	"data" -- payload message data
+//----------------------------------------------------------------------
+
+void
+PostOffice::Deliver(int box, PacketHeader pktHdr, MailHeader mailHdr,
+		    char *data)
+{
+    ASSERT((box >= 0) && (box < numBoxes));
+    ASSERT(mailHdr.length <= MaxMessageSize);
+
+    boxes[box].Put(pktHdr, mailHdr, data);
 }
 
 //----------------------------------------------------------------------
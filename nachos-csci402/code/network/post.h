@@ -30,6 +30,7 @@
 
 #include "network.h"
 #include "synchlist.h"
+#include "interrupt.h"
 
 // Mailbox address -- uniquely identifies a mailbox on a given machine.
 // A mailbox is just a place for temporary storage for messages.
@@ -52,6 +53,79 @@ class MailHeader {
 
 #define MaxMailSize 	(MaxPacketSize - sizeof(MailHeader))
 
+// Longer messages, up to MaxMessageSize bytes, are sent as several
+// packets ("fragments") of at most MaxMailSize bytes each, and put
+// back together in the receiving MailBox before anyone can Receive
+// them.  The buffer passed to Receive must be big enough for the
+// longest message that can be sent to that box.
+
+#define MaxMessageSize	1024
+
+// Reliable delivery (turned off with -nort).  Every message to another
+// machine gets a sequence number, and is kept and sent again every
+// RetransmitTimeout ticks until that machine acknowledges it; up to
+// SendWindow messages to one machine can be waiting for an
+// acknowledgement at once.  Acknowledgements are cumulative, and ride on
+// the next message going back if there is one within AckDelay ticks.
+// A machine only delivers the next message in sequence from each other
+// machine, dropping duplicates and anything after a lost message (the
+// sender sends those again).
+//
+// A machine that has acknowledged nothing for PeerTimeout seconds of
+// host time (not ticks: an idle Nachos jumps its clock ahead) is taken
+// to be gone.  Its unacknowledged messages are dropped, and Send to it
+// fails at once until it restarts.
+
+#define SendWindow		8
+#define RetransmitTimeout	(int64_t)10000LL
+#define AckDelay		(int64_t)500LL
+#define PeerTimeout		30.0	// host seconds
+#define MaxNetworkPeers		32	// machine ids must be less than this
+
+#define WireData	0x1	// the packet carries a message
+#define WireAck		0x2	// the packet acknowledges messages
+#define WireMore	0x4	// more fragments of the message follow
+#define WireContinued	0x8	// continues the message of the last packet
+
+// What goes on the wire in front of the message data: the MailHeader
+// packed into bytes, followed by the fields of the reliable transport.
+// It is the same size as a MailHeader, so MaxMailSize does not change.
+
+class WireHeader {
+  public:
+    unsigned char to;		// destination mail box
+    unsigned char from;		// mail box to reply to
+    unsigned char length;	// bytes of message data
+    unsigned char flags;	// WireData, WireAck, WireMore, WireContinued
+    unsigned short seq;		// sequence number of the message (WireData),
+				// or of the fragment if unreliable
+    unsigned short epoch;	// which run of the sender's Nachos sent it
+    unsigned short ack;		// every message before this one arrived
+    unsigned short ackEpoch;	// the run of ours "ack" is about (WireAck)
+};
+
+// The post office's view of one other machine: the messages we have sent
+// it that it has not acknowledged, and the next message we expect from it
+
+class PeerState {
+  public:
+    PeerState();
+
+    unsigned short nextSeq;	// sequence number of our next message
+    int numUnacked;		// sent messages waiting to be acknowledged
+    MailHeader unackedHdr[SendWindow];	// indexed by sequence number
+    char unackedData[SendWindow][MaxMailSize];	//   modulo SendWindow
+    unsigned char unackedFragment[SendWindow];	// WireMore, WireContinued
+    double waitingSince;	// host time of the last progress, while
+				//   there are unacked messages
+    bool down;			// given up on until it restarts
+
+    bool knowsPeer;		// have we heard from this run of it yet?
+    unsigned short peerEpoch;	// the run we are hearing from
+    unsigned short expectedSeq;	// the next message we can deliver
+    bool ackPending;		// we owe it an acknowledgement
+};
+
 
 // The following class defines the format of an incoming/outgoing 
 // "Mail" message.  The message format is layered: 
@@ -64,10 +138,15 @@ class Mail {
      Mail(PacketHeader pktH, MailHeader mailH, char *msgData);
 				// Initialize a mail message by
 				// concatenating the headers to the data
+     ~Mail();
+
+     void Append(char *moreData, int length);
+				// Add the next fragment of the message
 
      PacketHeader pktHdr;	// Header appended by Network
      MailHeader mailHdr;	// Header appended by PostOffice
-     char data[MaxMailSize];	// Payload -- message data
+     char *data;		// Payload -- message data
+     int fragments;		// how many packets it arrived in so far
 };
 
 // The following class defines a single mailbox, or temporary storage
@@ -82,12 +161,20 @@ class MailBox {
 
     void Put(PacketHeader pktHdr, MailHeader mailHdr, char *data);
    				// Atomically put a message into the mailbox
+    void PutFragment(PacketHeader pktHdr, MailHeader mailHdr, char *data,
+		     int index, bool more);
+				// Add a fragment to the message it belongs
+				// to; put the message in the mailbox when
+				// it is complete.  Called only by the
+				// postal worker.
     void Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data); 
    				// Atomically get a message out of the 
 				// mailbox (and wait if there is no message 
 				// to get!)
   private:
     SynchList *messages;	// A mailbox is just a list of arrived messages
+    List *partial;		// Messages still missing fragments, at most
+				// one per sending machine and mailbox
 };
 
 // The following class defines a "Post Office", or a collection of 
@@ -110,13 +197,19 @@ class PostOffice {
     bool Send(PacketHeader pktHdr, MailHeader mailHdr, char *data);
     				// Send a message to a mailbox on a remote 
 				// machine.  The fromBox in the MailHeader is 
-				// the return box for ack's.
+				// the return box for ack's.  Messages can
+				// be up to MaxMessageSize bytes.
     
     void Receive(int box, PacketHeader *pktHdr, 
 		MailHeader *mailHdr, char *data);
     				// Retrieve a message from "box".  Wait if
 				// there is no message in the box.
 
+    void Deliver(int box, PacketHeader pktHdr, MailHeader mailHdr,
+		 char *data);	// Put a message that arrived for one of
+				// our boxes into another one, without
+				// going through the network
+
     void PostalDelivery();	// Wait for incoming messages, 
 				// and then put them in the correct mailbox
 
@@ -128,6 +221,15 @@ class PostOffice {
 				// off of network (i.e., time to call 
 				// PostalDelivery)
 
+    void Flush();		// Wait until every message we have sent
+				// has been acknowledged, and send any
+				// acknowledgements we owe
+
+    void TransportWork();	// Wait for the transport's timers, and
+				// send acknowledgements and retransmissions
+    void RetransmitTimerExpired(); // Interrupt handlers for the
+    void AckTimerExpired();	// transport's timers
+
   private:
     Network *network;		// Physical network connection
     NetworkAddress netAddr;	// Network address of this machine
@@ -136,6 +238,32 @@ class PostOffice {
     Semaphore *messageAvailable;// V'ed when message has arrived from network
     Semaphore *messageSent;	// V'ed when next message can be sent to network
     Lock *sendLock;		// Only one outgoing message at a time
+    Lock *fragmentLock;		// Only one message sent in fragments at
+				// a time, so their fragments don't mix
+
+    bool SendFragment(NetworkAddress to, MailHeader mailHdr, char *data,
+		      int fragment, unsigned short index);
+				// Send one packet's worth of a message
+    bool SendPacket(NetworkAddress to, MailHeader mailHdr, char *data,
+		    int flags, unsigned short seq);
+				// Put one message on the network, with
+				// an acknowledgement for "to" if we owe one
+    void Acknowledged(PeerState *peer, WireHeader *wire);
+				// Forget the messages "wire" acknowledges
+    bool Accept(PeerState *peer, WireHeader *wire);
+				// Should an arriving message be delivered?
+    void StartRetransmitTimer();
+    void ResetRetransmitTimer();	// after an ack: start over or stop
+
+    bool reliable;		// use the reliable transport?
+    unsigned short epoch;	// tells this run apart from earlier ones
+    PeerState *peers;		// indexed by machine id
+    Lock *transportLock;	// protects "peers" and the timers
+    Condition *acksArrived;	// signalled when messages are acknowledged
+    Semaphore *transportWork;	// V'ed when one of the timers goes off
+    InterruptHandle retransmitTimer;
+    InterruptHandle ackTimer;
+    bool retransmitDue, ackDue;	// which timers have gone off
 };
 
 #endif
@@ -0,0 +1,54 @@
+/*
+Grouped Broadcast test.  WAITERS threads wait on one condition, and main
+broadcasts it once they all are waiting.  The server grants the lock to
+this machine once for all of them, in one message, and the kernel hands
+it from one woken thread to the next; each adds one to a monitor value
+with a GetMonitor and a SetMonitor, which only adds up if they really do
+hold the lock one at a time.
+	nachos -m 0     and     nachos -x ../test/broadcastGroup -m 1
+must print "Woken: 8".  With -ns 2 (both Nachos and a second server) the
+lock and condition are on different servers, and the condition's server
+sends the lock's server one request for the whole machine.
+*/
+
+#include "syscall.h"
+
+#define WAITERS 8
+
+int lock, cond, waiting, woken;
+
+void waiter() {
+	Acquire(lock);
+	FetchAndAddMonitor(waiting, 0, 1);
+	Wait(lock, cond);
+	SetMonitor(woken, 0, GetMonitor(woken, 0) + 1);
+	Release(lock);
+	Exit(0);
+}
+
+int main() {
+	int ids[WAITERS], i, broadcast;
+
+	lock = CreateLock("groupLock", 9, 0);
+	cond = CreateCondition("groupCond", 9, 0);
+	waiting = CreateMonitor("groupWaiting", 12, 1);
+	woken = CreateMonitor("groupWoken", 10, 1);
+	for (i = 0; i < WAITERS; i++) {
+		ids[i] = Fork(waiter, i);
+	}
+	broadcast = 0;
+	while (!broadcast) {
+		Acquire(lock);
+		if (GetMonitor(waiting, 0) == WAITERS) {
+			Broadcast(lock, cond);
+			broadcast = 1;
+		}
+		Release(lock);
+		Yield();
+	}
+	for (i = 0; i < WAITERS; i++) {
+		JoinThread(ids[i]);
+	}
+	Printf("Woken: %d\n", GetMonitor(woken, 0));
+	Exit(0);
+}
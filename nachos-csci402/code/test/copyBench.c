@@ -0,0 +1,98 @@
+/*
+File copy benchmark.
+Writes a FILE_SIZE byte file, copies it RECORD_SIZE bytes at a time and
+checks the copy.  Built twice by the Makefile: copyBench copies with one
+Read and one Write per record, copyBenchV (compiled with -DUSE_IOVEC)
+moves RECORDS_PER_CALL records per ReadV and WriteV.  Compare the total
+ticks, the host time and the "Syscall" lines printed by the two runs.
+*/
+
+#include "syscall.h"
+
+#define FILE_SIZE 32768
+#define RECORD_SIZE 64
+#define RECORDS_PER_CALL 16
+#define BLOCK_SIZE (RECORD_SIZE * RECORDS_PER_CALL)
+
+char records[RECORDS_PER_CALL][RECORD_SIZE];
+char block[BLOCK_SIZE];
+
+char patternAt(int offset) {
+	return 'a' + (offset % 26);
+}
+
+/* Creates the source file, one block per Write in both versions */
+void makeSource() {
+	OpenFileId fd;
+	int offset, i;
+
+	Create("copySource", 10);
+	fd = Open("copySource", 10);
+	for (offset = 0; offset < FILE_SIZE; offset += BLOCK_SIZE) {
+		for (i = 0; i < BLOCK_SIZE; i++) {
+			block[i] = patternAt(offset + i);
+		}
+		Write(block, BLOCK_SIZE, fd);
+	}
+	Close(fd);
+}
+
+/* Copies copySource to copyDest; returns the number of bytes copied */
+int copyFile() {
+	OpenFileId in, out;
+	int copied = 0, n;
+#ifdef USE_IOVEC
+	IOVec vec[RECORDS_PER_CALL];
+	int i;
+
+	for (i = 0; i < RECORDS_PER_CALL; i++) {
+		vec[i].buf = records[i];
+		vec[i].len = RECORD_SIZE;
+	}
+#endif
+
+	Create("copyDest", 8);
+	in = Open("copySource", 10);
+	out = Open("copyDest", 8);
+#ifdef USE_IOVEC
+	while ((n = ReadV(vec, RECORDS_PER_CALL, in)) > 0) {
+		WriteV(vec, (n + RECORD_SIZE - 1) / RECORD_SIZE, out);
+		copied += n;
+	}
+#else
+	while ((n = Read(records[0], RECORD_SIZE, in)) > 0) {
+		Write(records[0], n, out);
+		copied += n;
+	}
+#endif
+	Close(in);
+	Close(out);
+	return copied;
+}
+
+/* Returns the number of bytes of copyDest that differ from the pattern */
+int checkCopy() {
+	OpenFileId fd;
+	int offset = 0, errors = 0, n, i;
+
+	fd = Open("copyDest", 8);
+	while ((n = Read(block, BLOCK_SIZE, fd)) > 0) {
+		for (i = 0; i < n; i++) {
+			if (block[i] != patternAt(offset + i)) {
+				errors++;
+			}
+		}
+		offset += n;
+	}
+	Close(fd);
+	return errors + (FILE_SIZE - offset);
+}
+
+int main() {
+	int copied;
+
+	makeSource();
+	copied = copyFile();
+	Printf("Copied %d bytes, %d bytes wrong\n", copied, checkCopy());
+	Exit(0);
+}
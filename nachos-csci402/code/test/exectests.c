@@ -5,10 +5,15 @@
 #include "syscall.h"
 
 int main(){
+  int id, status;
   Write("Testing Exec Calls\n", 19, ConsoleOutput);
-  /*Testing that exec works */
-  Exec("../test/matmult");
-  Exec("../test/testfiles");
+  /*Testing that exec works, and that Join waits for the program and returns its exit status */
+  id = Exec("../test/matmult");
+  status = Join(id);
+  PrintString("matmult exited with status ", 27); PrintNum(status); PrintNl();
+  id = Exec("../test/testfiles");
+  status = Join(id);
+  PrintString("testfiles exited with status ", 29); PrintNum(status); PrintNl();
   /*Testing that program doesn't execute these invalid inputs into Execs. */
   Exec("../awdawd");
   Exec("../awdawd");
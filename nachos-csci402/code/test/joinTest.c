@@ -0,0 +1,34 @@
+/*
+This file tests JoinThread.
+The main thread forks three workers, waits for each of them with
+JoinThread and prints the status each one passed to Exit.
+*/
+
+#include "syscall.h"
+
+int sum = 0;
+
+void worker() {
+	int myNumber = GetThreadArgs();
+	Sleep(myNumber * 1000);
+	sum += myNumber;
+	Exit(myNumber * 10);
+}
+
+int main() {
+	int ids[3], i, status;
+
+	for(i = 0; i < 3; ++i) {
+		ids[i] = Fork(worker, i + 1);
+	}
+	for(i = 0; i < 3; ++i) {
+		status = JoinThread(ids[i]);
+		PrintString("Worker exited with status ", 26); PrintNum(status); PrintNl();
+	}
+	/* All workers are done, so this must print 6 */
+	PrintString("Sum: ", 5); PrintNum(sum); PrintNl();
+	/* Joining an id that is not one of our threads fails */
+	status = JoinThread(-5);
+	PrintString("Bad JoinThread returned ", 24); PrintNum(status); PrintNl();
+	Exit(0);
+}
@@ -0,0 +1,31 @@
+/*
+Lock cache test.  Takes the same server lock ROUNDS times, and each time
+adds one to a server monitor value with a GetMonitor and a SetMonitor,
+which only adds up if the lock really is held by one thread at a time.
+With -lc the client keeps the lock after the first Acquire, so the rest
+never go to the server:
+	nachos -m 0     and     nachos -lc -x ../test/lockCache -m 1
+Start a second client at once (-lc -m 2) and the server revokes the lock
+whenever the other machine asks for it; the client that finishes last
+must print "Count: 400".
+*/
+
+#include "syscall.h"
+
+#define ROUNDS 200
+
+int main() {
+	int lock, counter, i;
+
+	lock = CreateLock("cachedLock", 10, 0);
+	counter = CreateMonitor("cachedCount", 11, 1);
+	for (i = 0; i < ROUNDS; i++) {
+		Acquire(lock);
+		SetMonitor(counter, 0, GetMonitor(counter, 0) + 1);
+		Release(lock);
+	}
+	Acquire(lock);
+	Printf("Count: %d\n", GetMonitor(counter, 0));
+	Release(lock);
+	Exit(0);
+}
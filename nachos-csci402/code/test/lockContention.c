@@ -0,0 +1,26 @@
+/*
+Lock contention benchmark for the lock server.
+Every client that runs this program acquires and releases the same server
+lock ITERATIONS times, so with several clients running at once most
+Acquires have to wait in the lock's queue and are woken by a Release.
+Start the server with "nachos -m 0", then several clients at once:
+	nachos -x ../test/lockContention -m 1
+	nachos -x ../test/lockContention -m 2   ... up to -m 5
+The server prints its average wake-up time every 1000 wake-ups.
+*/
+
+#include "syscall.h"
+
+#define ITERATIONS 500
+
+int main() {
+	int lock, i;
+
+	lock = CreateLock("contendedLock", 13, 0);
+	for (i = 0; i < ITERATIONS; i++) {
+		Acquire(lock);
+		Release(lock);
+	}
+	Printf("Done %d acquires of lock %d\n", ITERATIONS, lock);
+	Exit(0);
+}
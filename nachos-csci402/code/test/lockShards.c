@@ -0,0 +1,47 @@
+/*
+Lock server throughput benchmark with independent locks.
+WORKERS threads each acquire and release their own server lock ROUNDS
+times, so the threads of one client never wait for each other (clients
+run at once share the locks by name).  With several server workers (-sw)
+the locks are in different shards and the requests are handled by
+different server threads.  Compare the server's
+and the clients' host time with
+	nachos -sw 1 -m 0     and     nachos -sw 4 -m 0
+each with several clients started at once:
+	nachos -x ../test/lockShards -m 1   (and -m 2, -m 3 in other windows)
+*/
+
+#include "syscall.h"
+
+#define WORKERS 4
+#define ROUNDS 100
+
+int locks[WORKERS];
+
+void worker() {
+	int lock, i;
+
+	lock = locks[GetThreadArgs()];
+	for (i = 0; i < ROUNDS; i++) {
+		Acquire(lock);
+		Release(lock);
+	}
+	Exit(0);
+}
+
+int main() {
+	int ids[WORKERS], i;
+
+	locks[0] = CreateLock("shardLock0", 10, 0);
+	locks[1] = CreateLock("shardLock1", 10, 0);
+	locks[2] = CreateLock("shardLock2", 10, 0);
+	locks[3] = CreateLock("shardLock3", 10, 0);
+	for (i = 0; i < WORKERS; i++) {
+		ids[i] = Fork(worker, i);
+	}
+	for (i = 0; i < WORKERS; i++) {
+		JoinThread(ids[i]);
+	}
+	Printf("Done %d acquires of each of %d locks\n", ROUNDS, WORKERS);
+	Exit(0);
+}
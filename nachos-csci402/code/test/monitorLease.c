@@ -0,0 +1,35 @@
+/*
+Monitor cache test.  Run it on two clients at once: the first to start
+polls a "done" monitor value with GetMonitor until it is set, the second
+sleeps a while and then sets it.  With -mc the poller's GetMonitors are
+answered from its cache, and it still sees the value change, because the
+server tells it when the value is set:
+	nachos -m 0
+	nachos -mc 5000 -x ../test/monitorLease -m 1   and   nachos -mc 5000 -x ../test/monitorLease -m 2
+The poller must print "Saw done", and with -d l its kernel prints how
+many GetMonitors it answered without the server.
+*/
+
+#include "syscall.h"
+
+#define SETTER_SLEEP 20000
+
+int main() {
+	int roles, done, polls;
+
+	roles = CreateMonitor("leaseRoles", 10, 1);
+	done = CreateMonitor("leaseDone", 9, 1);
+	if (FetchAndAddMonitor(roles, 0, 1) == 0) {
+		polls = 0;
+		while (GetMonitor(done, 0) == 0) {
+			polls++;
+			Yield();
+		}
+		Printf("Saw done after %d polls\n", polls);
+	} else {
+		Sleep(SETTER_SLEEP);
+		SetMonitor(done, 0, 1);
+		Printf("Set done\n");
+	}
+	Exit(0);
+}
@@ -0,0 +1,71 @@
+/*
+This file tests the bulk and atomic monitor calls of the lock server.
+It creates a LINES value monitor (the size of a clerk line count array),
+writes all of it with one SetMonitorRange and reads it back with one
+GetMonitorRange, where one GetMonitor per value would take LINES round
+trips.  Then WORKERS threads each add 1 to a counter ADDS times with
+FetchAndAddMonitor and no lock, and one CompareAndSwapMonitor succeeds
+and one fails.
+Start the server with "nachos -m 0", then "nachos -x ../test/monitorRange -m 1".
+*/
+
+#include "syscall.h"
+
+#define LINES 20
+#define WORKERS 4
+#define ADDS 25
+
+int lineCounts;
+int counter;
+
+void worker() {
+	int i;
+
+	for (i = 0; i < ADDS; i++) {
+		FetchAndAddMonitor(counter, 0, 1);
+	}
+	Exit(0);
+}
+
+int main() {
+	int values[LINES], ids[WORKERS], i, wrong;
+
+	lineCounts = CreateMonitor("rangeLineCounts", 15, LINES);
+	counter = CreateMonitor("rangeCounter", 12, 1);
+
+	for (i = 0; i < LINES; i++) {
+		values[i] = i * 3;
+	}
+	SetMonitorRange(lineCounts, 0, LINES, values);
+	for (i = 0; i < LINES; i++) {
+		values[i] = -1;
+	}
+	GetMonitorRange(lineCounts, 0, LINES, values);
+	wrong = 0;
+	for (i = 0; i < LINES; i++) {
+		if (values[i] != i * 3) {
+			wrong++;
+		}
+	}
+	/* Must print 0 wrong */
+	Printf("Range: %d values, %d wrong\n", LINES, wrong);
+	/* Must fail: only LINES values */
+	Printf("Past the end: %d\n", GetMonitorRange(lineCounts, LINES - 1, 2, values));
+
+	SetMonitor(counter, 0, 0);
+	for (i = 0; i < WORKERS; i++) {
+		ids[i] = Fork(worker, i);
+	}
+	for (i = 0; i < WORKERS; i++) {
+		JoinThread(ids[i]);
+	}
+	/* Must print WORKERS * ADDS = 100 */
+	Printf("Counter: %d\n", GetMonitor(counter, 0));
+
+	/* The first swap finds 100 and sets 7, the second finds 7 and does nothing */
+	Printf("Swap: %d", CompareAndSwapMonitor(counter, 0, 100, 7));
+	Printf(" then %d\n", CompareAndSwapMonitor(counter, 0, 100, 8));
+	/* Must fail: the counter has one value, so this is MonitorError and not a value */
+	Printf("Bad add is MonitorError: %d\n", FetchAndAddMonitor(counter, 1, 1) == MonitorError);
+	Exit(0);
+}
@@ -0,0 +1,51 @@
+/*
+This file tests the lock server split between several server machines.
+With 2 or 3 servers, "multiLock" and "multiCond" hash to different
+servers, so the Wait and Signal below have the condition's server ask
+the lock's server to release and reacquire the lock.  A worker waits on
+the condition; main signals it once the "multiFlag" monitor says it is
+waiting, and the worker must wake up holding the lock.
+Start the servers, then the client (its machine id after the servers'):
+	nachos -ns 2 -m 0
+	nachos -ns 2 -m 1
+	nachos -ns 2 -x ../test/multiServer -m 2
+*/
+
+#include "syscall.h"
+
+int lock, cond, flag;
+
+void worker() {
+	Acquire(lock);
+	SetMonitor(flag, 0, 1);
+	Wait(lock, cond);
+	SetMonitor(flag, 0, 2);	/* we have the lock again */
+	Release(lock);
+	Exit(0);
+}
+
+int main() {
+	int id, signalled;
+
+	lock = CreateLock("multiLock", 9, 0);
+	cond = CreateCondition("multiCond", 9, 0);
+	flag = CreateMonitor("multiFlag", 9, 1);
+	Printf("Lock %d, condition %d, monitor %d\n", lock, cond, flag);
+	SetMonitor(flag, 0, 0);
+
+	id = Fork(worker, 0);
+	signalled = 0;
+	while (!signalled) {
+		Acquire(lock);
+		if (GetMonitor(flag, 0) == 1) {
+			Signal(lock, cond);
+			signalled = 1;
+		}
+		Release(lock);
+		Yield();
+	}
+	JoinThread(id);
+	/* Must print 2 */
+	Printf("Woke up: %d\n", GetMonitor(flag, 0));
+	Exit(0);
+}
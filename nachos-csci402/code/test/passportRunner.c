@@ -1,8 +1,12 @@
 #include "syscall.h"
 
 int main() {
-	Exec("../test/passportoffice");
-	Exec("../test/passportoffice");
+	int first, second;
+	first = Exec("../test/passportoffice");
+	second = Exec("../test/passportoffice");
 
+	/* Wait for both offices to close, without spinning */
+	Join(first);
+	Join(second);
 	Exit(0);
-}
\ No newline at end of file
+}
@@ -12,6 +12,7 @@
 #define SENATOR_NUMBER 10
 #define false 0
 #define true 1
+#define TICKS_PER_YIELD 100 /* simulated time to Sleep() for, for each Yield() that a busy wait loop used to make */
 
 void ApplicationClerk(); /* used to have int myLine in parameter */
 void PictureClerk();
@@ -433,20 +434,25 @@ void PrintCust(int isCustomer) {
     }
 }
 
+char* CustString(int isCustomer) {
+    return isCustomer ? "Customer_" : "Senator_";
+}
+
+/* Each of these prints its whole line with one Printf instead of a trap per piece */
 void hasSignaledString(int isCustomer, char* threadName, int threadNameLength, int clerkNum, int custNumber) {
-    PrintString(threadName, threadNameLength); PrintNum(clerkNum); PrintString(" has signalled ", 15);
-    PrintCust(isCustomer); PrintNum(custNumber); PrintString(" to come to their counter. (", 28);
-    PrintCust(isCustomer); PrintNum(custNumber); PrintString(")", 1); PrintNl();
+    char* who = CustString(isCustomer);
+    Printf("%s%d has signalled %s%d to come to their counter. (%s%d)\n",
+        threadName, clerkNum, who, custNumber, who, custNumber);
 }
 
 void givenSSNString(int isCustomer, int custNumber, char* threadName, int threadNameLength, int clerkNum) {
-    PrintCust(isCustomer); PrintNum(custNumber); PrintString(" has given SSN ", 15);
-    PrintNum(custNumber); PrintString(" to ", 4); PrintString(threadName, threadNameLength); PrintNum(clerkNum); PrintNl();
+    Printf("%s%d has given SSN %d to %s%d\n",
+        CustString(isCustomer), custNumber, custNumber, threadName, clerkNum);
 }
 
 void recievedSSNString(int isCustomer, char* threadName, int threadNameLength, int clerkNum, int custNumber) {
-    PrintString(threadName, threadNameLength); PrintNum(clerkNum); PrintString(" has received SSN ", 18); PrintNum(custNumber);
-    PrintString(" from ", 6); PrintCust(isCustomer); PrintNum(custNumber); PrintNl();
+    Printf("%s%d has received SSN %d from %s%d\n",
+        threadName, clerkNum, custNumber, CustString(isCustomer), custNumber);
 }
 
 void ApplicationClerk() {
@@ -472,9 +478,7 @@ void ApplicationClerk() {
 
 /* CL: random time for applicationclerk to process data */
         numYields = Rand(80, 20);
-        for(i = 0; i < numYields; ++i) {
-            Yield();
-        }
+        Sleep(numYields * TICKS_PER_YIELD);
 
         customerAttributes[custNumber].applicationIsFiled = true;
         PrintString("ApplicationClerk_", 17); PrintNum(myLine);
@@ -525,9 +529,7 @@ void PictureClerk() {
                 PrintString("PictureClerk_", 13); PrintNum(myLine); PrintString(" has been told that ", 20); PrintCust(isCustomer); PrintNum(custNumber); PrintString(" does like their picture\n", 25);
                 /* CL: random time for pictureclerk to process data */
 
-                for(i = 0; i < numYields; ++i) {
-                    Yield();
-                }
+                Sleep(numYields * TICKS_PER_YIELD);
             }else{
                 PrintCust(isCustomer); PrintNum(custNumber); PrintString(" does not like their picture from ", 34);
                 PrintString("PictureClerk_", 13); PrintNum(myLine); PrintNl();
@@ -582,9 +584,7 @@ void PassportClerk() {
             } else {
                 PrintString("PassportClerk_", 14); PrintNum(myLine); PrintString(" has recorded ", 14);
                 PrintCust(isCustomer); PrintNum(custNumber); PrintString(" passport documentation\n", 24);
-                for(i = 0; i < numYields; ++i) {
-                    Yield();
-                }
+                Sleep(numYields * TICKS_PER_YIELD);
                 customerAttributes[custNumber].clerkMessedUp = false;
                 customerAttributes[custNumber].hasCertification = true;
             }
@@ -631,9 +631,7 @@ void Cashier() {
             clerkStates[myLine] = BUSY;
             numYields = Rand(80, 20);
             /* CL: yields after processing money*/
-            for(i = 0; i < numYields; ++i) {
-                Yield();
-            }
+            Sleep(numYields * TICKS_PER_YIELD);
             clerkMessedUp = Rand(100, 0);
             if(custNumber > 49){
                 clerkMessedUp = 100;
@@ -787,9 +785,7 @@ void Customer() {
         if(customerAttributes[custNumber].clerkMessedUp) {
             PrintString("Clerk messed up.  Customer is going to the back of the line.\n", 61);
             yieldTime = Rand(900, 100);
-            for(i = 0; i < yieldTime; ++i) {
-                Yield();
-            }
+            Sleep(yieldTime * TICKS_PER_YIELD);
             customerAttributes[custNumber].clerkMessedUp = false;
         }
     }
@@ -994,9 +990,7 @@ void Manager() {
         /* (void) interrupt->SetLevel(oldLevel); /*restore interrupts*/
         Release(outsideLock);
         waitTime = 100;
-        for(i = 0; i < waitTime; ++i) {
-            Yield();
-        }
+        Sleep(waitTime * TICKS_PER_YIELD);
     } while(!customersAreAllDone());
     allCustomersAreDone = true;
     wakeUpClerks();
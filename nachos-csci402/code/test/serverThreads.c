@@ -0,0 +1,45 @@
+/*
+This file tests several threads of one client machine using the lock
+server at the same time.  Each worker takes the shared server lock
+ROUNDS times and, while holding it, increments a counter and yields so
+the other workers' Acquires are waiting on the server.  Every thread has
+its own reply mailbox, so each Acquire's reply wakes the thread that
+asked for it, and the counter must come out exact.
+Start the server with "nachos -m 0", then "nachos -x ../test/serverThreads -m 1".
+*/
+
+#include "syscall.h"
+
+#define WORKERS 4
+#define ROUNDS 20
+
+int lock;
+int counter = 0;
+
+void worker() {
+	int i, before;
+
+	for (i = 0; i < ROUNDS; i++) {
+		Acquire(lock);
+		before = counter;
+		Yield();
+		counter = before + 1;
+		Release(lock);
+	}
+	Exit(0);
+}
+
+int main() {
+	int ids[WORKERS], i;
+
+	lock = CreateLock("serverThreadsLock", 17, 0);
+	for (i = 0; i < WORKERS; i++) {
+		ids[i] = Fork(worker, i);
+	}
+	for (i = 0; i < WORKERS; i++) {
+		JoinThread(ids[i]);
+	}
+	/* Must print WORKERS * ROUNDS = 80 */
+	Printf("Counter: %d\n", counter);
+	Exit(0);
+}
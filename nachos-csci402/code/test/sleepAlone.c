@@ -0,0 +1,14 @@
+/*
+This file tests Sleep when no other thread can run.
+The main thread is the only thread, so while it sleeps Nachos is idle
+and only the alarm can wake it.  It must print both lines and exit.
+*/
+
+#include "syscall.h"
+
+int main() {
+	PrintString("Sleeping with no other thread\n", 30);
+	Sleep(10000);
+	PrintString("Woke up alone\n", 14);
+	Exit(0);
+}
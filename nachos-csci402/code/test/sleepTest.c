@@ -0,0 +1,26 @@
+/*
+This file tests the Sleep syscall.
+Three threads sleep for different amounts of time, forked longest first,
+and must wake up shortest first.
+*/
+
+#include "syscall.h"
+
+void sleeper() {
+	int ticks = GetThreadArgs();
+	Sleep(ticks);
+	PrintString("Woke up after sleeping ", 23);
+	PrintNum(ticks);
+	PrintString(" ticks\n", 7);
+	Exit(0);
+}
+
+int main() {
+	Fork(sleeper, 30000);
+	Fork(sleeper, 20000);
+	Fork(sleeper, 10000);
+	/* Sleeping for 0 ticks returns right away */
+	Sleep(0);
+	PrintString("Main thread done sleeping 0 ticks\n", 34);
+	Exit(0);
+}
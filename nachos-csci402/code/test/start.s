@@ -274,6 +274,78 @@ DestroyMonitor:
 	j	$31
 	.end DestroyMonitor
 
+	.globl Sleep
+	.ent	Sleep
+Sleep:
+	addiu $2,$0,SC_Sleep
+	syscall
+	j	$31
+	.end Sleep
+
+	.globl JoinThread
+	.ent	JoinThread
+JoinThread:
+	addiu $2,$0,SC_JoinThread
+	syscall
+	j	$31
+	.end JoinThread
+
+	.globl Printf
+	.ent	Printf
+Printf:
+	addiu $2,$0,SC_Printf
+	syscall
+	j	$31
+	.end Printf
+
+	.globl ReadV
+	.ent	ReadV
+ReadV:
+	addiu $2,$0,SC_ReadV
+	syscall
+	j	$31
+	.end ReadV
+
+	.globl WriteV
+	.ent	WriteV
+WriteV:
+	addiu $2,$0,SC_WriteV
+	syscall
+	j	$31
+	.end WriteV
+
+	.globl GetMonitorRange
+	.ent	GetMonitorRange
+GetMonitorRange:
+	addiu $2,$0,SC_GetMonitorRange
+	syscall
+	j	$31
+	.end GetMonitorRange
+
+	.globl SetMonitorRange
+	.ent	SetMonitorRange
+SetMonitorRange:
+	addiu $2,$0,SC_SetMonitorRange
+	syscall
+	j	$31
+	.end SetMonitorRange
+
+	.globl CompareAndSwapMonitor
+	.ent	CompareAndSwapMonitor
+CompareAndSwapMonitor:
+	addiu $2,$0,SC_CompareAndSwapMonitor
+	syscall
+	j	$31
+	.end CompareAndSwapMonitor
+
+	.globl FetchAndAddMonitor
+	.ent	FetchAndAddMonitor
+FetchAndAddMonitor:
+	addiu $2,$0,SC_FetchAndAddMonitor
+	syscall
+	j	$31
+	.end FetchAndAddMonitor
+
 /* dummy function to keep gcc happy */
         .globl  __main
         .ent    __main
@@ -129,6 +129,38 @@ List::Remove()
     return SortedRemove(NULL);  // Same as SortedRemove, but ignore the key
 }
 
+//----------------------------------------------------------------------
+// List::RemoveFirstMatch
+//      Remove the first "item" on the list for which "match"(item, arg)
+//	returns TRUE, wherever it is on the list.
+//
+// Returns:
+//	Pointer to removed item, NULL if no item matched.
+//----------------------------------------------------------------------
+
+void *
+List::RemoveFirstMatch(MatchFunctionPtr match, int arg)
+{
+    ListElement *prev = NULL;
+    void *thing;
+
+    for (ListElement *ptr = first; ptr != NULL; prev = ptr, ptr = ptr->next) {
+	if (!(*match)(ptr->item, arg))
+	    continue;
+	if (prev == NULL)
+	    first = ptr->next;
+	else
+	    prev->next = ptr->next;
+	if (last == ptr)
+	    last = prev;
+	thing = ptr->item;
+	delete ptr;
+	--size;
+	return thing;
+    }
+    return NULL;
+}
+
 //----------------------------------------------------------------------
 // List::Mapcar
 //	Apply a function to each item on the list, by walking through
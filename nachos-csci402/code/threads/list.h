@@ -16,6 +16,9 @@
 #include "copyright.h"
 #include "utility.h"
 
+// A test applied to the items on a list by List::RemoveFirstMatch.
+typedef bool (*MatchFunctionPtr)(void *item, int arg);
+
 // The following class defines a "list element" -- which is
 // used to keep track of one item on a list.  It is equivalent to a
 // LISP cell, with a "car" ("next") pointing to the next element on the list,
@@ -48,6 +51,9 @@ class List {
     void Prepend(void *item); 	// Put item at the beginning of the list
     void Append(void *item); 	// Put item at the end of the list
     void *Remove(); 	 	// Take item off the front of the list
+    void *RemoveFirstMatch(MatchFunctionPtr match, int arg);
+				// Take the first item for which
+				// match(item, arg) is TRUE off the list
 
     void Mapcar(VoidFunctionPtr func);	// Apply "func" to every element
 					// on the list
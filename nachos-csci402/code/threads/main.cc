@@ -13,17 +13,26 @@
 //		-f -cp <unix file> <nachos file>
 //		-p <nachos file> -r <nachos file> -l -D -t
 //              -n <network reliability> -m <machine id>
-//              -o <other machine id>
+//              -o <other machine id> -nb <other machine id> -nort
+//              -nbl <other machine id> -sw <server workers> -ns <servers> -lc
+//              -mc <lease ticks>
 //              -z
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
 //    -z prints the copyright message
+//    -ib times 100,000 scheduled interrupts (interrupt queue benchmark)
+//    -tb times forking 20,000 short-lived threads (thread pool benchmark)
+//    -mlfq schedules threads with a multilevel feedback queue instead of FIFO
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
 //    -x runs a user program
 //    -c tests the console
+//    -nodc turns off the simulator's decoded instruction cache
+//    -bb runs user programs with the threaded-code (basic block) engine
+//	and can't be combined with -nodc
+//    -aff prefers scheduling threads of the current address space
 //
 //  FILESYS
 //    -f causes the physical disk to be formatted
@@ -38,6 +47,17 @@
 //    -n sets the network reliability
 //    -m sets this machine's host id (needed for the network)
 //    -o runs a simple test of the Nachos network software
+//    -nb streams messages to and from another machine (network benchmark)
+//    -nbl is -nb with messages long enough to be sent in fragments
+//    -nort turns off the post office's reliable transport
+//    -sw sets how many worker threads the lock server (-m) runs; 0 for
+//        the old single-threaded server
+//    -ns sets how many lock servers there are (machines 0 to n - 1); the
+//        servers and every client must be given the same number
+//    -lc keeps the server locks this (client) machine's threads acquire,
+//        until the server asks for them back
+//    -mc keeps the monitor values this (client) machine reads for the given
+//        number of ticks, unless the server says they have been set
 //
 //  NOTE -- flags are ignored until the relevant assignment.
 //  Some of the flags are interpreted here; some in system.cc.
@@ -60,7 +80,10 @@ extern void ThreadTest(void), Copy(char *unixFile, char *nachosFile);
 extern void Print(char *file), PerformanceTest(void);
 extern void StartProcess(char *file), ConsoleTest(char *in, char *out);
 extern void MailTest(int networkID);
-extern void Server();
+extern void NetworkBenchmark(int farAddr, bool longMessages);
+extern void Server(int machineId);
+extern void InterruptBenchmark();
+extern void ThreadBenchmark();
 
 //----------------------------------------------------------------------
 // main
@@ -93,6 +116,10 @@ main(int argc, char **argv)
 	argCount = 1;
         if (!strcmp(*argv, "-z"))               // print copyright
             printf (copyright);
+        if (!strcmp(*argv, "-ib"))              // time the interrupt queue
+            InterruptBenchmark();
+        if (!strcmp(*argv, "-tb"))              // time thread creation
+            ThreadBenchmark();
 #ifdef USER_PROGRAM
         if (!strcmp(*argv, "-x")) {        	// run a user program
 	    ASSERT(argc > 1);
@@ -144,9 +171,20 @@ main(int argc, char **argv)
 
         }
 
+        if (!strcmp(*argv, "-nb")) {		// time the post office
+	    ASSERT(argc > 1);
+            NetworkBenchmark(atoi(*(argv + 1)), FALSE);
+            argCount = 2;
+        } else if (!strcmp(*argv, "-nbl")) {	// ... with long messages
+	    ASSERT(argc > 1);
+            NetworkBenchmark(atoi(*(argv + 1)), TRUE);
+            argCount = 2;
+        }
+
         if (!strcmp(*argv, "-m")) {
+	    ASSERT(argc > 1);
         	cout << "Main in" << endl;
-        	Server();
+        	Server(atoi(*(argv + 1)));
         }
         
 
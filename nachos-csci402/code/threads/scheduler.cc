@@ -11,8 +11,9 @@
 //	end up calling FindNextToRun(), and that would put us in an 
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+// 	By default, no priorities, straight FIFO.  With -mlfq, a 
+//	multilevel feedback queue: threads that block are favored over
+//	threads that use up their time slices.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -30,6 +31,15 @@
 Scheduler::Scheduler()
 { 
     readyList = new List; 
+    for (int i = 0; i < NumPriorities; i++)
+	levelList[i] = new List;
+    lastBoost = 0;
+    sleepingList = new List;
+    alarmWhen = 0;
+    affinityRun = 0;
+#ifdef USER_PROGRAM
+    lastSpace = NULL;
+#endif
 } 
 
 //----------------------------------------------------------------------
@@ -40,6 +50,9 @@ Scheduler::Scheduler()
 Scheduler::~Scheduler()
 { 
     delete readyList; 
+    for (int i = 0; i < NumPriorities; i++)
+	delete levelList[i];
+    delete sleepingList;
 } 
 
 //----------------------------------------------------------------------
@@ -48,6 +61,11 @@ Scheduler::~Scheduler()
 //	Put it on the ready list, for later scheduling onto the CPU.
 //
 //	"thread" is the thread to be put on the ready list.
+//
+//	With MLFQ, a thread that was BLOCKED (woken up by Semaphore::V,
+//	Lock::Release or Condition::Signal) is moved back to level 0, so
+//	that a thread that just got a lock can finish its critical section
+//	ahead of the CPU-bound threads.
 //----------------------------------------------------------------------
 
 void
@@ -55,8 +73,21 @@ Scheduler::ReadyToRun (Thread *thread)
 {
     DEBUG('t', "Putting thread %s on ready list.\n", thread->getName());
 
+    thread->readySince = stats->totalTicks;
+    if (!useMLFQ) {
+	thread->setStatus(READY);
+	readyList->Append((void *)thread);
+	return;
+    }
+
+    if (thread->getStatus() == BLOCKED) {
+	if (thread->priority > 0)
+	    stats->numPriorityBoosts++;
+	thread->priority = 0;
+	thread->slicesUsed = 0;
+    }
     thread->setStatus(READY);
-    readyList->Append((void *)thread);
+    levelList[thread->priority]->Append((void *)thread);
 }
 
 //----------------------------------------------------------------------
@@ -70,7 +101,191 @@ Scheduler::ReadyToRun (Thread *thread)
 Thread *
 Scheduler::FindNextToRun ()
 {
-    return (Thread *)readyList->Remove();
+    Thread *thread = NULL;
+
+    if (!useMLFQ)
+	thread = RemoveNext(readyList);
+    else
+	for (int i = 0; i < NumPriorities && thread == NULL; i++)
+	    thread = RemoveNext(levelList[i]);
+
+    if (thread != NULL) {		// how long did it wait?
+	int64_t waited = stats->totalTicks - thread->readySince;
+	stats->numDispatches++;
+	stats->readyWaitTicks += waited;
+	if (waited > stats->maxReadyWaitTicks)
+	    stats->maxReadyWaitTicks = waited;
+    }
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::RemoveNext
+// 	Take the next thread to run off one ready list.  Normally the
+//	one at the head; with -aff, the first one in the address space of
+//	the thread giving up the CPU, unless we have already done that
+//	MaxAffinityRun times in a row.
+//----------------------------------------------------------------------
+
+#ifdef USER_PROGRAM
+static bool
+InSpace(void *thread, int space)
+{
+    return ((Thread *)thread)->space == (AddrSpace *)space;
+}
+#endif
+
+Thread *
+Scheduler::RemoveNext (List *list)
+{
+#ifdef USER_PROGRAM
+    if (useSpaceAffinity && currentThread->space != NULL
+			&& affinityRun < MaxAffinityRun) {
+	Thread *thread = (Thread *)list->RemoveFirstMatch(InSpace,
+						(int)currentThread->space);
+	if (thread != NULL) {
+	    affinityRun++;
+	    return thread;
+	}
+    }
+#endif
+    affinityRun = 0;
+    return (Thread *)list->Remove();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::QuantumExpired
+// 	Called from the timer interrupt handler, with interrupts off, to
+//	decide whether the interrupted thread should yield.  With FIFO,
+//	always.  With MLFQ, only if the thread has used up its time
+//	slices at its level (and then it is moved down a level), or if a
+//	higher priority thread is waiting.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::QuantumExpired ()
+{
+    if (!useMLFQ)
+	return TRUE;
+
+    if (stats->totalTicks - lastBoost >= BoostInterval)
+	BoostAll();
+
+    currentThread->slicesUsed++;
+    if (currentThread->slicesUsed >= (1 << currentThread->priority)) {
+	if (currentThread->priority < NumPriorities - 1) {
+	    currentThread->priority++;
+	    stats->numPriorityDemotions++;
+	    DEBUG('t', "Thread \"%s\" moved down to level %d\n",
+		  currentThread->getName(), currentThread->priority);
+	}
+	currentThread->slicesUsed = 0;
+	return TRUE;
+    }
+
+    for (int i = 0; i < currentThread->priority; i++)
+	if (!levelList[i]->IsEmpty())
+	    return TRUE;
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::BoostAll
+// 	Move every ready thread, and the running one, back to level 0, so
+//	that CPU-bound threads at the bottom level are not starved by a
+//	steady stream of threads waking up.
+//----------------------------------------------------------------------
+
+void
+Scheduler::BoostAll ()
+{
+    Thread *thread;
+
+    lastBoost = stats->totalTicks;
+    for (int i = 1; i < NumPriorities; i++)
+	while ((thread = (Thread *)levelList[i]->Remove()) != NULL) {
+	    thread->priority = 0;
+	    thread->slicesUsed = 0;
+	    levelList[0]->Append((void *)thread);
+	    stats->numPriorityBoosts++;
+	}
+    currentThread->priority = 0;
+    currentThread->slicesUsed = 0;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SleepFor
+// 	Put the current thread to sleep until "ticks" from now.  Sleeping
+//	threads are kept in a list sorted by when they are to wake up, and
+//	the timer device is programmed to interrupt when the first one is
+//	due, so a sleeping thread costs no CPU, and if everyone is asleep
+//	Interrupt::Idle skips straight to the next wake up.
+//
+//	"ticks" is how long to sleep; nothing happens if it is <= 0.
+//----------------------------------------------------------------------
+
+static void
+AlarmHandler(int arg)
+{
+    Scheduler *sched = (Scheduler *)arg;
+    sched->WakeSleepers();
+}
+
+void
+Scheduler::SleepFor (int ticks)
+{
+    if (ticks <= 0)
+	return;
+
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int64_t when = stats->totalTicks + ticks;
+
+    DEBUG('t', "Thread \"%s\" sleeping until %lld\n", 
+	  currentThread->getName(), when);
+    sleepingList->SortedInsert((void *)currentThread, when);
+    SetAlarm(when);
+    currentThread->Sleep();
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SetAlarm
+// 	Make sure the alarm interrupt goes off no later than "when".
+//----------------------------------------------------------------------
+
+void
+Scheduler::SetAlarm (int64_t when)
+{
+    if (interrupt->IsPending(alarm) && alarmWhen <= when)
+	return;				// it already will
+    interrupt->Cancel(alarm);
+    alarmWhen = when;
+    alarm = interrupt->Schedule(AlarmHandler, (int)this,
+				when - stats->totalTicks, AlarmInt);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::WakeSleepers
+// 	The alarm went off; put every sleeping thread whose time is up
+//	back on the ready list, in the order they are due, and set the
+//	alarm for the next one.  Called with interrupts off.
+//----------------------------------------------------------------------
+
+void
+Scheduler::WakeSleepers ()
+{
+    Thread *thread;
+    int64_t when;
+
+    while ((thread = (Thread *)sleepingList->SortedRemove(&when)) != NULL) {
+	if (when > stats->totalTicks) {	// not yet; put it back
+	    sleepingList->SortedInsert((void *)thread, when);
+	    SetAlarm(when);
+	    return;
+	}
+	DEBUG('t', "Waking up thread \"%s\"\n", thread->getName());
+	ReadyToRun(thread);
+    }
 }
 
 //----------------------------------------------------------------------
@@ -95,8 +310,13 @@ Scheduler::Run (Thread *nextThread)
 #ifdef USER_PROGRAM			// ignore until running user programs 
     if (currentThread->space != NULL) {	// if this thread is a user program,
         currentThread->SaveUserState(); // save the user's CPU registers
-	currentThread->space->SaveState();
+	if (nextThread->space != currentThread->space)
+	    currentThread->space->SaveState();	// (threads of the same
+						// process share the TLB)
     }
+    if (nextThread->space != currentThread->space)
+	stats->numSpaceSwitches++;
+    lastSpace = currentThread->space;
 #endif
     
     oldThread->CheckOverflow();		    // check if the old thread
@@ -129,7 +349,8 @@ Scheduler::Run (Thread *nextThread)
 #ifdef USER_PROGRAM
     if (currentThread->space != NULL) {		// if there is an address space
         currentThread->RestoreUserState();     // to restore, do it.
-	currentThread->space->RestoreState();
+	if (currentThread->space != lastSpace)
+	    currentThread->space->RestoreState();
     }
 #endif
 }
@@ -143,5 +364,13 @@ void
 Scheduler::Print()
 {
     printf("Ready list contents:\n");
-    readyList->Mapcar((VoidFunctionPtr) ThreadPrint);
+    if (!useMLFQ) {
+	readyList->Mapcar((VoidFunctionPtr) ThreadPrint);
+	return;
+    }
+    for (int i = 0; i < NumPriorities; i++) {
+	printf("  level %d: ", i);
+	levelList[i]->Mapcar((VoidFunctionPtr) ThreadPrint);
+	printf("\n");
+    }
 }
@@ -12,6 +12,23 @@
 #include "copyright.h"
 #include "list.h"
 #include "thread.h"
+#include "interrupt.h"
+
+// Multilevel feedback queue parameters (used with -mlfq).  Level 0 is
+// the highest priority.  A thread at level i may run for 2^i timer
+// slices before it is moved down a level; a thread that wakes up from
+// a Semaphore, Lock or Condition goes back to level 0.
+#define NumPriorities	3
+#define BoostInterval	(50 * TimerTicks)	// how often every thread is
+						// moved back to level 0, so
+						// nothing starves
+
+// With -aff, the scheduler prefers a ready thread in the same address
+// space as the thread giving up the CPU, since switching between two
+// threads of one process does not flush the TLB.  To be fair to the
+// other processes, it goes back to the head of the ready list after
+// picking this many same-space threads in a row.
+#define MaxAffinityRun	8
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
@@ -27,10 +44,38 @@ class Scheduler {
 					// list, if any, and return thread.
     void Run(Thread* nextThread);	// Cause nextThread to start running
     void Print();			// Print contents of ready list
+
+    bool QuantumExpired();		// Called on each timer interrupt;
+					// TRUE if the current thread should
+					// give up the CPU
+
+    void SleepFor(int ticks);		// Put the current thread to sleep
+					// until "ticks" from now
+    void WakeSleepers();		// Called by the alarm interrupt, to
+					// wake up the threads whose time is up
     
   private:
     List *readyList;  		// queue of threads that are ready to run,
-				// but not running
+				// but not running (FIFO scheduling)
+    List *levelList[NumPriorities];	// the same, one queue per priority
+				// level (MLFQ scheduling)
+    int64_t lastBoost;		// when every thread was last moved to level 0
+    List *sleepingList;		// threads in SleepFor, sorted by when
+				// they are to wake up
+    InterruptHandle alarm;	// the interrupt that will wake up the
+				// first of them
+    int64_t alarmWhen;		// when "alarm" is due
+    int affinityRun;		// times in a row we picked a thread in
+				// the current address space (-aff)
+#ifdef USER_PROGRAM
+    AddrSpace *lastSpace;	// address space of the thread that last
+				// gave up the CPU
+#endif
+
+    void BoostAll();		// move every thread back to level 0
+    void SetAlarm(int64_t when);	// make sure the alarm goes off
+					// by "when"
+    Thread *RemoveNext(List *list);	// take the next thread off "list"
 };
 
 #endif // SCHEDULER_H
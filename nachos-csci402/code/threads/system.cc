@@ -36,6 +36,15 @@ OpenFile *swapfile;
 BitMap* swapfileBitmap;
 List* swapQueue;
 bool runWithFIFO = true;
+bool useDecodeCache = true;
+bool useBlockEngine = false;
+bool useMLFQ = false;
+bool useSpaceAffinity = false;
+bool useReliableTransport = true;
+int numServerWorkers = 4;
+int numServers = 1;
+bool useLockCache = false;
+int monitorLeaseTicks = 0;
 #ifdef FILESYS_NEEDED
 FileSystem  *fileSystem;
 #endif
@@ -50,6 +59,10 @@ Machine *machine;	// user program memory and registers
 
 #ifdef NETWORK
 PostOffice *postOffice;
+BitMap* replyMailboxMap;
+Semaphore* replyMailboxesFree;
+extern void StartLockCache();	// in lock_syscalls.cc
+extern void StartMonitorCache();
 #endif
 
 
@@ -77,7 +90,7 @@ extern void Cleanup();
 static void
 TimerInterruptHandler(int dummy)
 {
-    if (interrupt->getStatus() != IdleMode)
+    if (interrupt->getStatus() != IdleMode && scheduler->QuantumExpired())
 	interrupt->YieldOnReturn();
 }
 
@@ -158,6 +171,49 @@ Initialize(int argc, char **argv)
         argCount = 2;
 
     }
+    //Handling the -nodc argument, which turns off the decoded instruction cache
+    else if (!strcmp(*argv, "-nodc")) {
+        useDecodeCache = FALSE;
+    }
+    //Handling the -bb argument, which runs user programs with the threaded-code engine
+    else if (!strcmp(*argv, "-bb")) {
+        useBlockEngine = TRUE;
+    }
+    //Handling the -mlfq argument, which schedules threads with a multilevel feedback queue
+    else if (!strcmp(*argv, "-mlfq")) {
+        useMLFQ = TRUE;
+    }
+    //Handling the -aff argument, which prefers running threads of the current address space
+    else if (!strcmp(*argv, "-aff")) {
+        useSpaceAffinity = TRUE;
+    }
+    //Handling the -nort argument, which turns off the post office's reliable transport
+    else if (!strcmp(*argv, "-nort")) {
+        useReliableTransport = FALSE;
+    }
+    //Handling and saving the -sw argument, which sets the number of lock server worker threads
+    else if (!strcmp(*argv, "-sw")) {
+        ASSERT(argc > 1);
+        numServerWorkers = atoi(*(argv + 1));
+        argCount = 2;
+    }
+    //Handling and saving the -ns argument, which sets how many lock servers the entities are split between
+    else if (!strcmp(*argv, "-ns")) {
+        ASSERT(argc > 1);
+        numServers = atoi(*(argv + 1));
+        ASSERT(numServers > 0);
+        argCount = 2;
+    }
+    //Handling the -lc argument, which keeps the server locks this machine's threads acquire until another machine wants them
+    else if (!strcmp(*argv, "-lc")) {
+        useLockCache = TRUE;
+    }
+    //Handling and saving the -mc argument, which sets how many ticks a monitor value read from the server is kept
+    else if (!strcmp(*argv, "-mc")) {
+        ASSERT(argc > 1);
+        monitorLeaseTicks = atoi(*(argv + 1));
+        argCount = 2;
+    }
     userLocks[MAX_LOCK_COUNT];
     userConds[MAX_COND_COUNT];
     kernelLock = new Lock("KernelLock");
@@ -174,11 +230,18 @@ Initialize(int argc, char **argv)
     swapQueue = new List();
     }
 
+    // The threaded-code engine's blocks point into the decode cache,
+    // so there is no -bb without it
+    if (useBlockEngine && !useDecodeCache) {
+        printf("-bb runs out of the decoded instruction cache, so it can't be used with -nodc\n");
+        Exit(1);
+    }
+
     DebugInit(debugArgs);			// initialize DEBUG messages
     stats = new Statistics();			// collect statistics
     interrupt = new Interrupt;			// start up interrupt handling
     scheduler = new Scheduler();		// initialize the ready queue
-    if (randomYield)				// start the timer (if needed)
+    if (randomYield || useMLFQ)			// start the timer (if needed)
 	  timer = new Timer(TimerInterruptHandler, 0, randomYield);
 
     threadToBeDestroyed = NULL;
@@ -205,7 +268,13 @@ Initialize(int argc, char **argv)
 #endif
 
 #ifdef NETWORK
-    postOffice = new PostOffice(netname, rely, 10);
+    postOffice = new PostOffice(netname, rely, NumMailboxes);
+    replyMailboxMap = new BitMap(NumMailboxes);
+    replyMailboxMap->Mark(0);			// the server's mailbox
+    replyMailboxesFree = new Semaphore("reply mailboxes", NumMailboxes - 1);
+    StartLockCache();				// also takes the grouped Broadcast wake-ups
+    if (monitorLeaseTicks > 0)
+	StartMonitorCache();
 #endif
 }
 
@@ -45,11 +45,36 @@ struct UserCond {
 
 class ProcessEntry {
 	public:
+		ProcessEntry() {
+			space = NULL;
+			spaceId = 0;
+			parentId = 0;
+			sleepThreadCount = 0;
+			awakeThreadCount = 0;
+			exited = FALSE;
+			exitStatus = 0;
+			exitCondition = new Condition("ProcessExitCondition");
+			for(int i = 0; i < ADDRESS_SPACE_COUNT; ++i) {
+				stackLocations[i] = 0;
+				threadForked[i] = FALSE;
+				threadExited[i] = FALSE;
+				threadExitStatus[i] = 0;
+			}
+		}
 		AddrSpace* space;
 		SpaceId spaceId;
+		int parentId;						//Process id of the process that Exec'ed this one (0 for the first)
 		int sleepThreadCount;
 		int awakeThreadCount;
 		int stackLocations[ADDRESS_SPACE_COUNT];
+
+		//Join support: Exit records the status here and broadcasts exitCondition (with kernelLock)
+		bool exited;						//Has the last thread of this process exited?
+		int exitStatus;						//Status passed to Exit by that thread
+		Condition* exitCondition;			//Join and JoinThread wait on this
+		bool threadForked[ADDRESS_SPACE_COUNT];	//Indexed by thread id: was the thread started in this process?
+		bool threadExited[ADDRESS_SPACE_COUNT];	//Indexed by thread id: has it called Exit?
+		int threadExitStatus[ADDRESS_SPACE_COUNT];	//Indexed by thread id: the status it passed to Exit
 };
 
 class ProcessTable {
@@ -85,6 +110,15 @@ extern OpenFile *swapfile;			//SWAP file handler
 extern BitMap* swapfileBitmap;		//SWAP file bitmap to populate it
 extern List* swapQueue;				//List to be used as swap queue for FIFO eviction policy
 extern bool runWithFIFO;			//Boolean to indicate whether eviction policy is FIFO or random
+extern bool useDecodeCache;			//Boolean to indicate whether the simulator reuses decoded instructions
+extern bool useBlockEngine;			//Boolean to indicate whether user programs run as translated blocks
+extern bool useMLFQ;				//Boolean to indicate whether the scheduler is a multilevel feedback queue
+extern bool useSpaceAffinity;			//Boolean to indicate whether the scheduler prefers threads of the current address space
+extern bool useReliableTransport;		//Boolean to indicate whether the post office acknowledges and retransmits messages
+extern int numServerWorkers;			//Number of lock server worker threads, each owning a shard of the entities
+extern int numServers;				//Number of lock server machines (0 to numServers - 1) the entities are split between
+extern bool useLockCache;			//Boolean to indicate whether this machine keeps the server locks its threads acquire
+extern int monitorLeaseTicks;			//Ticks this machine keeps a monitor value it has read; 0 to always ask the server
 
 #ifdef USER_PROGRAM
 #include "machine.h"
@@ -103,7 +137,17 @@ extern SynchDisk   *synchDisk;
 
 #ifdef NETWORK
 #include "post.h"
+#define NumMailboxes 64		// mailbox 0 takes requests for the server;
+				// user threads receive their replies in the rest
+#define LockCacheMailbox (NumMailboxes - 1)	// the lock cache's mailbox on a client
+#define MonitorCacheMailbox (NumMailboxes - 2)	// the monitor cache's mailbox on a client (-mc)
+#define LockCacheGrant "*G"		// what the server sends a lock cache, followed
+#define LockCacheGroupGrant "*B"	// by the lock's index.  the '*' tells them
+#define LockCacheRevoke "*V"		// apart from the server's answers to the
+#define LockCacheNoLock "*I"		// locks the cache gives back
 extern PostOffice* postOffice;
+extern BitMap* replyMailboxMap;		// reply mailboxes in use
+extern Semaphore* replyMailboxesFree;	// counts the unused reply mailboxes
 #endif
 
 #endif // SYSTEM_H
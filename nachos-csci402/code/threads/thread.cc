@@ -24,6 +24,40 @@
 					// execution stack, for detecting 
 					// stack overflows
 
+// Workloads like forktests and passportoffice create hundreds of short
+// lived threads.  Rather than allocating (and mprotect'ing) a new stack
+// and a new Thread for each one, and freeing them again in Scheduler::Run
+// once the thread finishes, we keep up to ThreadPoolSize of each around.
+static int *freeStacks[ThreadPoolSize];	// stacks of deleted threads
+static int numFreeStacks = 0;
+static void *freeThreads[ThreadPoolSize];	// memory of deleted Threads
+static int numFreeThreads = 0;
+
+//----------------------------------------------------------------------
+// Thread::operator new, Thread::operator delete
+// 	Allocate the memory for a Thread, reusing one that was deleted if
+//	we can; return it to the pool when the Thread is deleted.
+//	Neither advances simulated time, so no interrupt (and no context
+//	switch) can happen in the middle of updating the pool.
+//----------------------------------------------------------------------
+
+void *
+Thread::operator new(size_t size)
+{
+    if (size == sizeof(Thread) && numFreeThreads > 0)
+	return freeThreads[--numFreeThreads];
+    return ::operator new(size);
+}
+
+void
+Thread::operator delete(void *p)
+{
+    if (numFreeThreads < ThreadPoolSize)
+	freeThreads[numFreeThreads++] = p;
+    else
+	::operator delete(p);
+}
+
 //----------------------------------------------------------------------
 // Thread::Thread
 // 	Initialize a thread control block, so that we can then call
@@ -40,8 +74,14 @@ Thread::Thread(char* threadName)
     status = JUST_CREATED;
     id = totalThreadCount;
     totalThreadCount++;
+    priority = 0;
+    slicesUsed = 0;
+    readySince = 0;
 #ifdef USER_PROGRAM
     space = NULL;
+    replyMailbox = -1;
+    ioBuffer = NULL;
+    ioBufferSize = 0;
 #endif
 }
 
@@ -62,7 +102,14 @@ Thread::~Thread()
     DEBUG('t', "Deleting thread \"%s\"\n", name);
 
     ASSERT(this != currentThread);
-    if (stack != NULL)
+#ifdef USER_PROGRAM
+    delete [] ioBuffer;
+#endif
+    if (stack == NULL)
+	return;
+    if (numFreeStacks < ThreadPoolSize)	// keep it for the next Fork
+	freeStacks[numFreeStacks++] = stack;
+    else
 	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
 }
 
@@ -241,8 +288,10 @@ void ThreadPrint(int arg){ Thread *t = (Thread *)arg; t->Print(); }
 
 //----------------------------------------------------------------------
 // Thread::StackAllocate
-//	Allocate and initialize an execution stack.  The stack is
-//	initialized with an initial stack frame for ThreadRoot, which:
+//	Allocate and initialize an execution stack, reusing the stack of
+//	a deleted thread if there is one (its guard pages are still
+//	protected).  The stack is initialized with an initial stack frame
+//	for ThreadRoot, which:
 //		enables interrupts
 //		calls (*func)(arg)
 //		calls Thread::Finish
@@ -254,7 +303,10 @@ void ThreadPrint(int arg){ Thread *t = (Thread *)arg; t->Print(); }
 void
 Thread::StackAllocate (VoidFunctionPtr func, int arg)
 {
-    stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+    if (numFreeStacks > 0)
+	stack = freeStacks[--numFreeStacks];
+    else
+	stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
 
 #ifdef HOST_SNAKE
     // HP stack works from low addresses to high addresses
@@ -319,4 +371,23 @@ Thread::RestoreUserState()
     for (int i = 0; i < NumTotalRegs; i++)
 	machine->WriteRegister(i, userRegisters[i]);
 }
+
+//----------------------------------------------------------------------
+// Thread::IOBuffer
+//	Return a kernel buffer of at least "size" bytes for moving data
+//	between this thread's address space and a file.  The buffer is
+//	kept until the thread is deleted, and only grows, so a program
+//	that reads or writes the same amount each time allocates once.
+//----------------------------------------------------------------------
+
+char *
+Thread::IOBuffer(int size)
+{
+    if (size > ioBufferSize) {
+	delete [] ioBuffer;
+	ioBufferSize = (size < MinIOBufferSize) ? MinIOBufferSize : size;
+	ioBuffer = new char[ioBufferSize];
+    }
+    return ioBuffer;
+}
 #endif
@@ -55,6 +55,14 @@
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
 #define StackSize	(4 * 1024)	// in words
 
+// How many finished Thread objects, and how many of their stacks, are
+// kept around to be reused by the next threads that are created.
+#define ThreadPoolSize	128
+
+// Smallest kernel buffer a user thread's Read and Write syscalls get; it
+// grows to fit the largest request the thread has made.
+#define MinIOBufferSize	1024
+
 
 // Thread state
 enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED };
@@ -87,6 +95,10 @@ class Thread {
 					// must not be running when delete 
 					// is called
 
+    void *operator new(size_t size);	// Thread objects come from, and
+    void operator delete(void *p);	// go back to, a pool of finished
+					// threads (see thread.cc)
+
     // basic thread operations
 
     void Fork(VoidFunctionPtr func, int arg); 	// Make thread run (*func)(arg)
@@ -99,11 +111,15 @@ class Thread {
     void CheckOverflow();   			// Check if thread has 
 						// overflowed its stack
     void setStatus(ThreadStatus st) { status = st; }
+    ThreadStatus getStatus() { return status; }
     char* getName() { return (name); }
     void Print() { printf("%s, ", name); }
 
     int id;
-    int stackLocations[1000];
+
+    int priority;			// MLFQ level, 0 is the highest
+    int slicesUsed;			// timer slices used at this level
+    int64_t readySince;			// when it was put on the ready list
 
   private:
     // some of the private data for this class is listed above
@@ -128,8 +144,17 @@ class Thread {
   public:
     void SaveUserState();		// save user-level register state
     void RestoreUserState();		// restore user-level register state
+    char *IOBuffer(int size);		// kernel buffer of at least "size"
+					// bytes for this thread's Read and
+					// Write syscalls; reused between calls
 
     AddrSpace *space;			// User code this thread is running.
+    int replyMailbox;			// mailbox its server replies come
+					// to, or -1 before its first request
+
+  private:
+    char *ioBuffer;			// NULL until the first Read or Write
+    int ioBufferSize;
 #endif
 };
 
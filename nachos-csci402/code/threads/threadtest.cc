@@ -1146,3 +1146,90 @@ ThreadTest()
     //TestSuite();
     Part2();
 }
+
+//----------------------------------------------------------------------
+// InterruptBenchmark
+//  Microbenchmark for the pending interrupt queue.  Schedule 100,000
+//  interrupts at random times, cancel every fourth one, and then run
+//  simulated time forward until all the others have fired, printing
+//  the host time each phase took.  Run with "nachos -ib".
+//----------------------------------------------------------------------
+
+static int benchFired;		// number of benchmark interrupts handled
+
+static void
+BenchHandler(int arg)
+{
+    benchFired++;
+}
+
+void
+InterruptBenchmark()
+{
+    const int numEvents = 100000;
+    InterruptHandle *events = new InterruptHandle[numEvents];
+    int numCancelled = 0;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    double start = HostSeconds();
+    for (int i = 0; i < numEvents; i++)
+        events[i] = interrupt->Schedule(BenchHandler, i,
+                                        1 + Random() % numEvents, DiskInt);
+    double scheduled = HostSeconds();
+
+    for (int i = 0; i < numEvents; i += 4) {
+        interrupt->Cancel(events[i]);
+        numCancelled++;
+    }
+    double cancelled = HostSeconds();
+
+    benchFired = 0;
+    while (benchFired < numEvents - numCancelled)
+        interrupt->Idle();		// jump ahead to the next interrupt
+    double finished = HostSeconds();
+
+    (void) interrupt->SetLevel(oldLevel);
+    delete [] events;
+
+    printf("Interrupt queue: scheduled %d in %.3f s, cancelled %d in %.3f s, "
+           "fired %d in %.3f s\n", numEvents, scheduled - start,
+           numCancelled, cancelled - scheduled, benchFired, finished - cancelled);
+}
+
+//----------------------------------------------------------------------
+// ThreadBenchmark
+//  Microbenchmark for thread creation.  Fork 20,000 threads that do
+//  nothing, 100 at a time, waiting for each batch to finish before
+//  starting the next, and print the host time it took.  Finished
+//  threads' Thread objects and stacks are reused by the next batch.
+//  Run with "nachos -tb".
+//----------------------------------------------------------------------
+
+static int benchThreadsDone;	// number of benchmark threads finished
+
+static void
+BenchThread(int arg)
+{
+    benchThreadsDone++;
+}
+
+void
+ThreadBenchmark()
+{
+    const int numBatches = 200, batchSize = 100;
+
+    double start = HostSeconds();
+    benchThreadsDone = 0;
+    for (int i = 0; i < numBatches; i++) {
+        for (int j = 0; j < batchSize; j++) {
+            Thread *t = new Thread("bench thread");
+            t->Fork(BenchThread, j);
+        }
+        while (benchThreadsDone < (i + 1) * batchSize)
+            currentThread->Yield();	// let the batch run and finish
+    }
+    double finished = HostSeconds();
+
+    printf("Threads: forked and finished %d in %.3f s\n",
+           numBatches * batchSize, finished - start);
+}
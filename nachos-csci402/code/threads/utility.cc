@@ -30,6 +30,7 @@ DebugInit(char *flagList)
     enableFlags = flagList;
 }
 
+#ifndef NO_TRACE
 //----------------------------------------------------------------------
 // DebugIsEnabled
 //      Return TRUE if DEBUG messages with "flag" are to be printed.
@@ -63,3 +64,4 @@ DEBUG(char flag, char *format, ...)
 	fflush(stdout);
     }
 }
+#endif // NO_TRACE
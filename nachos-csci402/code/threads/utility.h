@@ -60,10 +60,18 @@ typedef void (*VoidNoArgFunctionPtr)();
 
 extern void DebugInit(char* flags);	// enable printing debug messages
 
+#ifdef NO_TRACE
+// The "nachos-fast" build (see Makefile.common) compiles all tracing out:
+// -d is still accepted, but no flag is ever enabled, so every DEBUG
+// call and "if (DebugIsEnabled(...))" block disappears at compile time.
+#define DebugIsEnabled(flag)	FALSE
+#define DEBUG(flag, ...)	do { } while (0)
+#else
 extern bool DebugIsEnabled(char flag); 	// Is this debug flag enabled?
 
 extern void DEBUG (char flag, char* format, ...);  	// Print debug message 
 							// if flag is enabled
+#endif
 
 //----------------------------------------------------------------------
 // ASSERT
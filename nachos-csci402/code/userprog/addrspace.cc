@@ -120,6 +120,7 @@ SwapHeader (NoffHeader *noffH)
 AddrSpace::AddrSpace(OpenFile *filename) : fileTable(MaxOpenFiles) {
   pageTableLock = new Lock("PageTableLock");
   pageTableLock->Acquire();
+  consoleBufferLength = 0;
   lockCount = 0;
   condCount = 0;
   condsLock = new Lock ("CondsLock");
@@ -190,6 +191,7 @@ return;
 
 AddrSpace::~AddrSpace()
 {
+  ConsoleFlush();
   //Deleteing the pagetable and closing the executable
   delete executable;
   delete pageTable;
@@ -203,6 +205,37 @@ AddrSpace::~AddrSpace()
   // delete [] userConds;
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::ConsoleWrite
+//  Add "len" bytes of output for the console to this process' buffer.
+//  A line is written out to the host in one go once it is complete (or
+//  once the buffer is full), instead of one printf per character.
+//----------------------------------------------------------------------
+
+void AddrSpace::ConsoleWrite(char *buf, int len)
+{
+  for (int i = 0; i < len; i++) {
+    consoleBuffer[consoleBufferLength++] = buf[i];
+    if (buf[i] == '\n' || consoleBufferLength == ConsoleBufferSize) {
+      ConsoleFlush();
+    }
+  }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ConsoleFlush
+//  Write out whatever console output is buffered.  Called at the end of
+//  each line, on Exit, and before Nachos halts.
+//----------------------------------------------------------------------
+
+void AddrSpace::ConsoleFlush()
+{
+  if (consoleBufferLength > 0) {
+    fwrite(consoleBuffer, 1, consoleBufferLength, stdout);
+    consoleBufferLength = 0;
+  }
+}
+
 //----------------------------------------------------------------------
 // AddrSpace::InitRegisters
 //  Set the initial values for the user-level register set.
@@ -252,6 +285,7 @@ void AddrSpace::SaveState()
         }
         machine->tlb[i].valid = FALSE;
     }
+    machine->FlushTranslationCache();
 
 }
 
@@ -272,6 +306,7 @@ void AddrSpace::RestoreState()
         }
         machine->tlb[i].valid = FALSE;
     }
+    machine->FlushTranslationCache();
 
 
 }
@@ -330,6 +365,7 @@ void AddrSpace::DeleteCurrentThread(){
             machine->tlb[j].valid = FALSE;    
         }
       }
+      machine->FlushTranslationCache();
     }
 
     pageTable[stackLocation + i].valid = FALSE;
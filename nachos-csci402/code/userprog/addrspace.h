@@ -25,6 +25,9 @@
 #define MAX_THREADS_IN_PROCESS 100
 #define MAX_PROCESSES_IN_TABLE 100
 
+#define ConsoleBufferSize 256   // bytes of console output a process buffers
+                                // before writing them out
+
 
 struct UserLock;
 struct UserCond;
@@ -58,6 +61,10 @@ class AddrSpace {
     int NewPageTable();
     void DeleteCurrentThread();
     void PrintPageTable();
+    void ConsoleWrite(char *buf, int len);  // Buffer console output; it is
+                    // written out at each newline, when the buffer
+                    // fills up, and by ConsoleFlush
+    void ConsoleFlush();        // Write out any buffered console output
 
     int currentPCReg_space;
     int nextPCReg_space;
@@ -73,6 +80,8 @@ class AddrSpace {
     ExtendedTranslationEntry  *pageTable;   // Assume linear page table translation
     OpenFile *executable; //A handler for the open file associated with the address space
  private:
+    char consoleBuffer[ConsoleBufferSize]; //Console output not yet written out
+    int consoleBufferLength;
     Lock *pageTableLock;
     unsigned int numPages;      // Number of pages in the virtual address space 
     ProcessEntry* processEntry;
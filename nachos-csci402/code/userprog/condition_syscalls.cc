@@ -45,6 +45,7 @@ int CreateCondition_sys(int vaddr, int size, int appendNum) {
 
 // condition wait syscall
 void Wait_sys(int lockIndex, int conditionIndex) {
+    uncacheLock(lockIndex); // the condition releases and reacquires the lock for this thread
 	string receivedString = sendAndRecieveMessage("C W ", "", lockIndex, conditionIndex, -1);
     cout << "Client::Wait::receivedString: " << receivedString << endl;
 }
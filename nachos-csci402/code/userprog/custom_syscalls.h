@@ -8,6 +8,11 @@ enum UpadateState {SLEEP, AWAKE, FINISH};
 void sendToServer(PacketHeader &pktHdr, MailHeader &mailHdr, char* serverCode, char name[], int entityIndex1, int entityIndex2);
 string getFromServer(PacketHeader &pktHdr, MailHeader &mailHdr);
 string sendAndRecieveMessage(char* sysCode, char* name, int entityIndex1, int entityIndex2, int entityIndex3);
+int currentReplyMailbox();
+void releaseReplyMailbox();
+void StartLockCache();
+void uncacheLock(int lockIndex);
+void StartMonitorCache();
 
 void updateProcessThreadCounts(AddrSpace* addrSpace, UpadateState updateState);
 
@@ -20,6 +25,10 @@ int CreateMonitor_sys(int vaddr, int size, int appendNum);
 int GetMonitor_sys(int monitorIndex, int arrayIndex);
 void SetMonitor_sys(int monitorIndex, int arrayIndex, int value);
 void DestroyMonitor_sys(int monitorIndex);
+int GetMonitorRange_sys(int monitorIndex, int first, int count, int vaddr);
+int SetMonitorRange_sys(int monitorIndex, int first, int count, int vaddr);
+int CompareAndSwapMonitor_sys(int monitorIndex, int arrayIndex, int expected, int newValue);
+int FetchAndAddMonitor_sys(int monitorIndex, int arrayIndex, int amount);
 
 int CreateCondition_sys(int vaddr, int size, int appendNum);
 void Wait_sys(int lockIndex, int conditionIndex);
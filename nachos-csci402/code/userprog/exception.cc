@@ -42,48 +42,62 @@ int copyin(unsigned int vaddr, int len, char *buf) {
     // Copy len bytes from the current thread's virtual address vaddr.
     // Return the number of bytes so read, or -1 if an error occors.
     // Errors can generally mean a bad virtual address was passed in.
-    bool result;
+    // The bytes are copied a page at a time, straight out of main memory,
+    // once the page has been translated.
     int n=0;			// The number of bytes copied in
-    int *paddr = new int;
-
-    while ( n >= 0 && n < len) {
-      result = machine->ReadMem( vaddr, 1, paddr );
-      while(!result) { // FALL 09 CHANGES
-   			result = machine->ReadMem( vaddr, 1, paddr ); // FALL 09 CHANGES: TO HANDLE PAGE FAULT IN THE ReadMem SYS CALL
-      }
-
-      buf[n++] = *paddr;
-
-      if ( !result ) {
+    int physAddr, chunk;
+    ExceptionType exception;
+
+    while ( n < len ) {
+      exception = machine->Translate( vaddr, &physAddr, 1, FALSE );
+      if ( exception == PageFaultException ) {
+        // FALL 09 CHANGES: TO HANDLE PAGE FAULT IN THE ReadMem SYS CALL
+        machine->RaiseException( exception, vaddr );
+        continue;
+      } else if ( exception != NoException ) {
         //translation failed
         return -1;
       }
 
-      vaddr++;
+      chunk = PageSize - vaddr % PageSize;  // the rest of this page
+      if ( chunk > len - n ) {
+        chunk = len - n;
+      }
+      memcpy( &buf[n], &machine->mainMemory[physAddr], chunk );
+      n += chunk;
+      vaddr += chunk;
     }
 
-    delete paddr;
     return len;
 }
-
 int copyout(unsigned int vaddr, int len, char *buf) {
     // Copy len bytes to the current thread's virtual address vaddr.
     // Return the number of bytes so written, or -1 if an error
     // occors.  Errors can generally mean a bad virtual address was
-    // passed in.
-    bool result;
-    int n=0;			// The number of bytes copied in
-
-    while ( n >= 0 && n < len) {
-      // Note that we check every byte's address
-      result = machine->WriteMem( vaddr, 1, (int)(buf[n++]) );
-
-      if ( !result ) {
+    // passed in.  Like copyin, this copies a page at a time.
+    int n=0;			// The number of bytes copied out
+    int physAddr, chunk;
+    ExceptionType exception;
+
+    while ( n < len ) {
+      exception = machine->Translate( vaddr, &physAddr, 1, TRUE );
+      if ( exception == PageFaultException ) {
+        machine->RaiseException( exception, vaddr );
+        continue;
+      } else if ( exception != NoException ) {
         //translation failed
         return -1;
       }
 
-      vaddr++;
+      chunk = PageSize - vaddr % PageSize;
+      if ( chunk > len - n ) {
+        chunk = len - n;
+      }
+      memcpy( &machine->mainMemory[physAddr], &buf[n], chunk );
+      // the page may hold instructions we already decoded
+      machine->InvalidateDecodedFrame( physAddr / PageSize );
+      n += chunk;
+      vaddr += chunk;
     }
 
     return n;
@@ -181,21 +195,14 @@ void Write_Syscall(unsigned int vaddr, int len, int id) {
 
     if ( id == ConsoleInput) return;
 
-    if ( !(buf = new char[len]) ) {
-    	printf("%s","Error allocating kernel buffer for write!\n");
-    	return;
-    } else {
-        if ( copyin(vaddr,len,buf) == -1 ) {
-    	    printf("%s","Bad pointer passed to to write: data not written\n");
-    	    delete[] buf;
-    	    return;
-        }
+    buf = currentThread->IOBuffer(len);
+    if ( copyin(vaddr,len,buf) == -1 ) {
+        printf("%s","Bad pointer passed to to write: data not written\n");
+        return;
     }
 
     if ( id == ConsoleOutput) {
-        for (int ii=0; ii<len; ii++) {
-            printf("%c",buf[ii]);
-        }
+        currentThread->space->ConsoleWrite(buf, len);
     } else {
     	if ( (f = (OpenFile *) currentThread->space->fileTable.Get(id)) ) {
     	    f->Write(buf, len);
@@ -204,8 +211,6 @@ void Write_Syscall(unsigned int vaddr, int len, int id) {
     	    len = -1;
     	}
     }
-
-    delete[] buf;
 }
 
 int Read_Syscall(unsigned int vaddr, int len, int id) {
@@ -219,10 +224,7 @@ int Read_Syscall(unsigned int vaddr, int len, int id) {
 
     if ( id == ConsoleOutput) return -1;
 
-    if ( !(buf = new char[len]) ) {
-    	printf("%s","Error allocating kernel buffer in Read\n");
-    	return -1;
-    }
+    buf = currentThread->IOBuffer(len);
 
     if ( id == ConsoleInput) {
         //Reading from the keyboard
@@ -246,7 +248,97 @@ int Read_Syscall(unsigned int vaddr, int len, int id) {
     	   }
     }
 
-    delete[] buf;
+    return len;
+}
+
+int copyinIOVec(unsigned int vaddr, int count, int *bufs, int *lens) {
+    // Copy the "count" IOVec records at vaddr into bufs and lens.
+    // Return the total number of bytes they describe, or -1 if the
+    // vector is too long or can't be read.  The total is kept within
+    // MaxIOVecBytes, so it can't overflow, and the thread's IOBuffer
+    // doesn't grow to whatever size a program asks for.
+    int words[2 * MaxIOVecs];
+    int total = 0;
+
+    if ( count < 0 || count > MaxIOVecs ) {
+        printf("%s","Bad IOVec count passed to ReadV or WriteV\n");
+        return -1;
+    }
+    if ( copyin(vaddr, 8 * count, (char *) words) == -1 ) {
+        printf("%s","Bad IOVec pointer passed to ReadV or WriteV\n");
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        bufs[i] = WordToHost(words[2 * i]);
+        lens[i] = WordToHost(words[2 * i + 1]);
+        if ( lens[i] < 0 || lens[i] > MaxIOVecBytes - total ) {
+            printf("%s","Bad IOVec length passed to ReadV or WriteV\n");
+            return -1;
+        }
+        total += lens[i];
+    }
+    return total;
+}
+
+int WriteV_Syscall(unsigned int vaddr, int count, int id) {
+    // Gather the "count" buffers described by the IOVec array at vaddr
+    // into this thread's kernel buffer, and write them with one Write
+    // to the file (or console).  Return the number of bytes written, or -1.
+    int bufs[MaxIOVecs], lens[MaxIOVecs];
+    int total, n = 0;
+    char *buf;
+    OpenFile *f;
+
+    if ( id == ConsoleInput ) return -1;
+    if ( (total = copyinIOVec(vaddr, count, bufs, lens)) == -1 ) return -1;
+
+    buf = currentThread->IOBuffer(total);
+    for (int i = 0; i < count; i++) {
+        if ( copyin(bufs[i], lens[i], &buf[n]) == -1 ) {
+            printf("%s","Bad pointer passed to WriteV: data not written\n");
+            return -1;
+        }
+        n += lens[i];
+    }
+
+    if ( id == ConsoleOutput ) {
+        currentThread->space->ConsoleWrite(buf, total);
+    } else if ( (f = (OpenFile *) currentThread->space->fileTable.Get(id)) ) {
+        f->Write(buf, total);
+    } else {
+        printf("%s","Bad OpenFileId passed to WriteV\n");
+        return -1;
+    }
+    return total;
+}
+
+int ReadV_Syscall(unsigned int vaddr, int count, int id) {
+    // Read enough of the file to fill the "count" buffers described by
+    // the IOVec array at vaddr with one Read, and scatter it into them
+    // in order.  Return the number of bytes read, or -1.  The console
+    // is not supported.
+    int bufs[MaxIOVecs], lens[MaxIOVecs];
+    int total, len, chunk, n = 0;
+    char *buf;
+    OpenFile *f;
+
+    if ( id == ConsoleInput || id == ConsoleOutput ) return -1;
+    if ( (total = copyinIOVec(vaddr, count, bufs, lens)) == -1 ) return -1;
+
+    if ( !(f = (OpenFile *) currentThread->space->fileTable.Get(id)) ) {
+        printf("%s","Bad OpenFileId passed to ReadV\n");
+        return -1;
+    }
+    buf = currentThread->IOBuffer(total);
+    len = f->Read(buf, total);
+    for (int i = 0; i < count && n < len; i++) {
+        chunk = (lens[i] < len - n) ? lens[i] : len - n;
+        if ( copyout(bufs[i], chunk, &buf[n]) == -1 ) {
+            printf("%s","Bad pointer passed to ReadV: data not copied\n");
+            return -1;
+        }
+        n += chunk;
+    }
     return len;
 }
 
@@ -287,20 +379,159 @@ void PrintString_sys(unsigned int vaddr, int len) {
 
     buf[len]='\0';
 
-    for (int ii=0; ii<len; ii++) {
-        printf("%c",buf[ii]);
-    }
+    currentThread->space->ConsoleWrite(buf, len);
 
     delete[] buf;
 }
 
 void PrintNum_sys(int num) {
-    string numString = static_cast<ostringstream*>( &(ostringstream() << num) )->str();
-    cout << numString;
+    char numString[16];
+    int len = sprintf(numString, "%d", num);
+    currentThread->space->ConsoleWrite(numString, len);
 }
 
 void PrintNl_sys() {
-    printf("\n");
+    currentThread->space->ConsoleWrite("\n", 1);
+}
+
+//Copies the NUL-terminated string at vaddr into buf (at most size-1 characters); returns its length, or -1
+int copyinString(unsigned int vaddr, char *buf, int size) {
+    int n;
+    for (n = 0; n < size - 1; n++) {
+        if (copyin(vaddr + n, 1, &buf[n]) == -1) {
+            return -1;
+        }
+        if (buf[n] == '\0') {
+            return n;
+        }
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+//Gets the "index"th integer argument after the format string of a Printf call.  The first three
+//are in registers 5-7; by the MIPS calling convention, the caller put the rest on its stack, after
+//the 16 bytes reserved for the four register arguments.  Returns -1 if the stack can't be read
+int getPrintfArg(int index, int *value) {
+    if (index < 3) {
+        *value = machine->ReadRegister(5 + index);
+        return 0;
+    }
+    int vaddr = machine->ReadRegister(StackReg) + 16 + 4 * (index - 3);
+    if (copyin(vaddr, 4, (char *) value) == -1) { //copyin takes care of page faults
+        return -1;
+    }
+    *value = WordToHost(*value);
+    return 0;
+}
+
+//Printf: formats the NUL-terminated string at formatVaddr, with %d, %c, %s (a user string) and %%,
+//into the process' console buffer, so a whole line costs one syscall
+void Printf_sys(unsigned int formatVaddr) {
+    char format[MaxPrintfLength];
+    char text[MaxPrintfLength];
+    int argIndex = 0;
+    int arg;
+    int len;
+
+    if (copyinString(formatVaddr, format, MaxPrintfLength) == -1) {
+        printf("%s","Bad pointer passed to Printf\n");
+        return;
+    }
+    for (char *p = format; *p != '\0'; p++) {
+        if (*p != '%' || p[1] == '\0') {
+            currentThread->space->ConsoleWrite(p, 1);
+            continue;
+        }
+        ++p;
+        if ((*p == 'd' || *p == 'c' || *p == 's') && getPrintfArg(argIndex++, &arg) == -1) {
+            printf("%s","Bad argument pointer passed to Printf\n");
+            return;
+        }
+        switch (*p) {
+        case 'd':
+            len = sprintf(text, "%d", arg);
+            currentThread->space->ConsoleWrite(text, len);
+            break;
+        case 'c':
+            text[0] = (char) arg;
+            currentThread->space->ConsoleWrite(text, 1);
+            break;
+        case 's':
+            len = copyinString(arg, text, MaxPrintfLength);
+            if (len == -1) {
+                printf("%s","Bad string pointer passed to Printf\n");
+                return;
+            }
+            currentThread->space->ConsoleWrite(text, len);
+            break;
+        default:            //%% prints a %, and anything else is printed as is
+            currentThread->space->ConsoleWrite(p, 1);
+            break;
+        }
+    }
+}
+
+//Writes out the console output every running process has buffered, before Nachos halts
+void flushAllConsoleOutput() {
+    currentThread->space->ConsoleFlush();
+    for (int i = 1; i <= processCount && i < ADDRESS_SPACE_COUNT; i++) {
+        ProcessEntry* processEntry = processTable->processEntries[i];
+        if (processEntry != NULL && !processEntry->exited && processEntry->space != NULL) {
+            processEntry->space->ConsoleFlush();
+        }
+    }
+}
+
+//Blocks until the process "processId" (as returned by Exec) has exited, and returns its exit status
+int Join_sys(int processId) {
+    kernelLock->Acquire();
+    if(processId <= 0 || processId >= ADDRESS_SPACE_COUNT ||
+        processTable->processEntries[processId] == NULL ||
+        processTable->processEntries[processId]->parentId != currentThread->space->processId) {
+        printf("%s","Bad process id passed to Join\n");
+        kernelLock->Release();
+        return -1;
+    }
+    ProcessEntry* processEntry = processTable->processEntries[processId];
+    while(!processEntry->exited) {
+        processEntry->exitCondition->Wait(kernelLock); //Signalled from SC_Exit
+    }
+    int status = processEntry->exitStatus;
+    kernelLock->Release();
+    return status;
+}
+
+//Blocks until the thread "threadId" (as returned by Fork) of this process has exited, and returns its exit status
+int JoinThread_sys(int threadId) {
+    kernelLock->Acquire();
+    ProcessEntry* processEntry = processTable->processEntries[currentThread->space->processId];
+    if(threadId < 0 || threadId >= ADDRESS_SPACE_COUNT ||
+        !processEntry->threadForked[threadId] || threadId == currentThread->id) {
+        printf("%s","Bad thread id passed to JoinThread\n");
+        kernelLock->Release();
+        return -1;
+    }
+    while(!processEntry->threadExited[threadId]) {
+        processEntry->exitCondition->Wait(kernelLock); //Signalled from SC_Exit
+    }
+    int status = processEntry->threadExitStatus[threadId];
+    kernelLock->Release();
+    return status;
+}
+
+//Called from SC_Exit, with kernelLock held: records the exit status and wakes up anyone in Join or JoinThread
+void recordExit(int status, bool isLastThread) {
+    ProcessEntry* processEntry = processTable->processEntries[currentThread->space->processId];
+    if(currentThread->id < ADDRESS_SPACE_COUNT) {
+        processEntry->threadExited[currentThread->id] = TRUE;
+        processEntry->threadExitStatus[currentThread->id] = status;
+    }
+    if(isLastThread) {
+        processEntry->exited = TRUE;
+        processEntry->exitStatus = status;
+    }
+    processEntry->exitCondition->Broadcast(kernelLock);
 }
 
 void kernel_thread(int virtualAddress) {
@@ -377,6 +608,7 @@ int handleMemoryFull(){
             }
         }
     }
+    machine->FlushTranslationCache();
     //Storing the to-be-evicted page into the swapfile, if the dirty bit is set, and updating the connected pagetable
     if(ipt[pageToBoot].dirty){ 
         int swapLocationPPN = swapfileBitmap->Find();
@@ -403,6 +635,8 @@ int handleIPTMiss(int virtualPage){
         swapfile->ReadAt(&(machine->mainMemory[ppn * PageSize]), PageSize, pageTable[virtualPage].byteOffset);
         //NOTE: could add Clear from swapfile, cause now the page is in main memory
     }
+    //The frame has new contents, so its decoded instructions are stale
+    machine->InvalidateDecodedFrame(ppn);
     //If FIFO replacement policy was chosen, this will append the newly freed up page to the FIFO queue
     if(runWithFIFO){
         swapQueue->Append((void*)ppn);
@@ -451,217 +685,243 @@ void HandlePageFault(int virtualAddress) {
     tlb[tlbCounter % 4].use           = ipt[ppn].use;
     tlb[tlbCounter % 4].dirty         = ipt[ppn].dirty;
     tlb[tlbCounter % 4].readOnly      = ipt[ppn].readOnly;
+    machine->FlushTranslationCache();
 
     (void) interrupt->SetLevel(oldLevel); //restore interrupts
 }
 
+//Halt stops Nachos, printing the statistics
+void Halt_sys() {
+    //cout << "Halt is called by: " << currentThread->getName() << ", number of threads remaining in space: " << currentThread->space->threadCount <<  endl;
+    currentThread->space->PrintPageTable();
+
+    flushAllConsoleOutput();
+#ifdef NETWORK
+    postOffice->Flush(); //Our last request, or an ack we owe, may not have got through yet
+#endif
+    interrupt->Halt();
+}
+
+//Fork creates a new thread in the same address space, and returns its id
+int Fork_sys(int virtualAddress, int threadArg) {
+    kernelLock->Acquire();
+    if(totalThreadCount >= ADDRESS_SPACE_COUNT) { //The process table is indexed by thread id
+        printf("%s","Too many threads for Fork\n");
+        kernelLock->Release();
+        return -1;
+    }
+    Thread* kernelThread = new Thread("KernelThread");
+    threadArgs[kernelThread->id] = threadArg;
+    kernelThread->space = currentThread->space;
+    ++(currentThread->space->threadCount);
+    int startStackLocation = kernelThread->space->NewPageTable();
+    currentThread->space->RestoreState();
+    processTable->processEntries[currentThread->space->processId]->stackLocations[kernelThread->id] = startStackLocation;
+    processTable->processEntries[currentThread->space->processId]->threadForked[kernelThread->id] = TRUE;
+
+    kernelThread->Fork((VoidFunctionPtr)kernel_thread, virtualAddress);
+    kernelLock->Release();
+    return kernelThread->id; //For JoinThread
+}
+
+//Exec instantiates a new user program, and returns its process id
+int Exec_sys(int virtualAddress) {
+    kernelLock->Acquire();
+    if(totalThreadCount >= ADDRESS_SPACE_COUNT || processCount + 1 >= ADDRESS_SPACE_COUNT) { //The process table is indexed by both ids
+        printf("%s","Too many processes for Exec\n");
+        kernelLock->Release();
+        return -1;
+    }
+    //Increasing the process table count
+    processTable->runningProcessCount += 1;
+    char* nameOfProcess = new char[32 + 1];
+    if(copyin(virtualAddress, 32, nameOfProcess) == -1) {// Convert it to the physical address // read the contents from physical address, which will give you the name of the process to be executed
+        DEBUG('a', "Copyin failed.\n");
+        delete [] nameOfProcess;
+        kernelLock->Release();
+        return -1;
+    }
+    nameOfProcess[32] = '\0';
+    OpenFile *filePointer = fileSystem->Open(nameOfProcess);
+    delete [] nameOfProcess;
+
+    if (!filePointer){ // check if pointer is not null
+        printf("%s", "Couldn't open file\n");
+        kernelLock->Release();
+        return 0;
+    }
+    AddrSpace* as = new AddrSpace(filePointer); // Create new addrespace for this executable file
+    Thread* newThread = new Thread("ExecThread");
+    newThread->space = as; //Allocate the space created to this thread's space
+    processTable->processEntries[processCount] = new ProcessEntry();
+    processTable->processEntries[processCount]->space = as;
+    processTable->processEntries[processCount]->spaceId = processCount;
+    processTable->processEntries[processCount]->parentId = currentThread->space->processId;
+    processTable->processEntries[newThread->space->processId]->stackLocations[newThread->id] = as->StackTopForMain;
+    processTable->processEntries[newThread->space->processId]->threadForked[newThread->id] = TRUE;
+    newThread->Fork((VoidFunctionPtr)exec_thread, 0);
+    kernelLock->Release();
+    return as->processId; //For Join
+}
+
+//Exit finishes the current thread; if it is the last one, the process; and if that is the last one, Nachos
+void Exit_sys(int status) {
+    kernelLock->Acquire();
+#ifdef NETWORK
+    releaseReplyMailbox();
+#endif
+    currentThread->space->ConsoleFlush();
+    //Prints the result of the exit to the user program
+    printf("-----------Exit Output: %d\n", status);
+    //Checks for last process and last thread
+    bool isLastProcessVar = isLastProcess();
+    bool isLastExecutingThreadVar = isLastExecutingThread(currentThread);
+    recordExit(status, isLastExecutingThreadVar);
+    if(isLastProcessVar && isLastExecutingThreadVar) {
+    //This is the last process and last thread, can stop program
+        DEBUG('a', "Last process and last thread, stopping program.\n");
+        flushAllConsoleOutput();
+#ifdef NETWORK
+        postOffice->Flush(); //Our last request, or an ack we owe, may not have got through yet
+#endif
+        interrupt->Halt();
+    } else if(!isLastProcessVar && isLastExecutingThreadVar) {
+    //This is the last thread in a process, but not the last process, so we delete the entire addressspace
+        DEBUG('a', "Not last process and last thread, deleting process.\n");
+        cout << "Not last process and last thread, deleting process.\n" ;
+        delete currentThread->space;
+        processTable->runningProcessCount -= 1;
+
+        kernelLock->Release();
+        currentThread->Finish();
+
+    }else if(!isLastExecutingThreadVar) {
+      //Not last thread in process, so just delete thread
+      DEBUG('a', "Not last thread in a process, deleting thread.\n");
+      currentThread->space->DeleteCurrentThread();
+      kernelLock->Release();
+      currentThread->Finish();
+    }
+}
+
+//----------------------------------------------------------------------
+// Syscall dispatch table
+//  One entry per syscall code in syscall.h, in order.  Each handler
+//  gets the syscall's arguments (registers 4-6) and returns the value
+//  to put in register 2.
+//----------------------------------------------------------------------
+
+typedef int (*SyscallHandler)(int arg1, int arg2, int arg3);
+
+struct SyscallEntry {
+    char* name;                 //For DEBUG, and Statistics::Print
+    SyscallHandler handler;
+};
+
+static int HaltHandler(int arg1, int arg2, int arg3) { Halt_sys(); return 0; }
+static int ExitHandler(int arg1, int arg2, int arg3) { Exit_sys(arg1); return 0; }
+static int ExecHandler(int arg1, int arg2, int arg3) { return Exec_sys(arg1); }
+static int JoinHandler(int arg1, int arg2, int arg3) { return Join_sys(arg1); }
+static int CreateHandler(int arg1, int arg2, int arg3) { Create_Syscall(arg1, arg2); return 0; }
+static int OpenHandler(int arg1, int arg2, int arg3) { return Open_Syscall(arg1, arg2); }
+static int ReadHandler(int arg1, int arg2, int arg3) { return Read_Syscall(arg1, arg2, arg3); }
+static int WriteHandler(int arg1, int arg2, int arg3) { Write_Syscall(arg1, arg2, arg3); return 0; }
+static int CloseHandler(int arg1, int arg2, int arg3) { Close_Syscall(arg1); return 0; }
+static int ForkHandler(int arg1, int arg2, int arg3) { return Fork_sys(arg1, arg2); }
+static int YieldHandler(int arg1, int arg2, int arg3) { currentThread->Yield(); return 0; }
+static int CreateLockHandler(int arg1, int arg2, int arg3) { return CreateLock_sys(arg1, arg2, arg3); }
+static int AcquireHandler(int arg1, int arg2, int arg3) { Acquire_sys(arg1); return 0; }
+static int ReleaseHandler(int arg1, int arg2, int arg3) { Release_sys(arg1); return 0; }
+static int DestroyLockHandler(int arg1, int arg2, int arg3) { DestroyLock_sys(arg1); return 0; }
+static int CreateConditionHandler(int arg1, int arg2, int arg3) { return CreateCondition_sys(arg1, arg2, arg3); }
+static int WaitHandler(int arg1, int arg2, int arg3) { Wait_sys(arg1, arg2); return 0; }
+static int SignalHandler(int arg1, int arg2, int arg3) { Signal_sys(arg1, arg2); return 0; }
+static int BroadcastHandler(int arg1, int arg2, int arg3) { Broadcast_sys(arg1, arg2); return 0; }
+static int DestroyConditionHandler(int arg1, int arg2, int arg3) { DestroyCondition_sys(arg1); return 0; }
+static int RandHandler(int arg1, int arg2, int arg3) { return Rand_sys(arg1, arg2); }
+static int GetThreadArgsHandler(int arg1, int arg2, int arg3) { return GetThreadArgs_sys(); }
+static int PrintStringHandler(int arg1, int arg2, int arg3) { PrintString_sys(arg1, arg2); return 0; }
+static int PrintNumHandler(int arg1, int arg2, int arg3) { PrintNum_sys(arg1); return 0; }
+static int PrintNlHandler(int arg1, int arg2, int arg3) { PrintNl_sys(); return 0; }
+static int CreateMonitorHandler(int arg1, int arg2, int arg3) { return CreateMonitor_sys(arg1, arg2, arg3); }
+static int GetMonitorHandler(int arg1, int arg2, int arg3) { return GetMonitor_sys(arg1, arg2); }
+static int SetMonitorHandler(int arg1, int arg2, int arg3) { SetMonitor_sys(arg1, arg2, arg3); return 0; }
+static int DestroyMonitorHandler(int arg1, int arg2, int arg3) { DestroyMonitor_sys(arg1); return 0; }
+static int SleepHandler(int arg1, int arg2, int arg3) { scheduler->SleepFor(arg1); return 0; }
+static int JoinThreadHandler(int arg1, int arg2, int arg3) { return JoinThread_sys(arg1); }
+static int PrintfHandler(int arg1, int arg2, int arg3) { Printf_sys(arg1); return 0; } //reads its own arguments
+static int ReadVHandler(int arg1, int arg2, int arg3) { return ReadV_Syscall(arg1, arg2, arg3); }
+static int WriteVHandler(int arg1, int arg2, int arg3) { return WriteV_Syscall(arg1, arg2, arg3); }
+//The monitor range calls and CompareAndSwapMonitor have a fourth argument, in register 7
+static int GetMonitorRangeHandler(int arg1, int arg2, int arg3) { return GetMonitorRange_sys(arg1, arg2, arg3, machine->ReadRegister(7)); }
+static int SetMonitorRangeHandler(int arg1, int arg2, int arg3) { return SetMonitorRange_sys(arg1, arg2, arg3, machine->ReadRegister(7)); }
+static int CompareAndSwapMonitorHandler(int arg1, int arg2, int arg3) { return CompareAndSwapMonitor_sys(arg1, arg2, arg3, machine->ReadRegister(7)); }
+static int FetchAndAddMonitorHandler(int arg1, int arg2, int arg3) { return FetchAndAddMonitor_sys(arg1, arg2, arg3); }
+
+static SyscallEntry syscallTable[] = {
+    { "Halt", HaltHandler },                        //SC_Halt
+    { "Exit", ExitHandler },                        //SC_Exit
+    { "Exec", ExecHandler },                        //SC_Exec
+    { "Join", JoinHandler },                        //SC_Join
+    { "Create", CreateHandler },                    //SC_Create
+    { "Open", OpenHandler },                        //SC_Open
+    { "Read", ReadHandler },                        //SC_Read
+    { "Write", WriteHandler },                      //SC_Write
+    { "Close", CloseHandler },                      //SC_Close
+    { "Fork", ForkHandler },                        //SC_Fork
+    { "Yield", YieldHandler },                      //SC_Yield
+    { "CreateLock", CreateLockHandler },            //SC_CreateLock
+    { "Acquire", AcquireHandler },                  //SC_Acquire
+    { "Release", ReleaseHandler },                  //SC_Release
+    { "DestroyLock", DestroyLockHandler },          //SC_DestroyLock
+    { "CreateCondition", CreateConditionHandler },  //SC_CreateCondition
+    { "Wait", WaitHandler },                        //SC_Wait
+    { "Signal", SignalHandler },                    //SC_Signal
+    { "Broadcast", BroadcastHandler },              //SC_Broadcast
+    { "DestroyCondition", DestroyConditionHandler },//SC_DestroyCondition
+    { "Rand", RandHandler },                        //SC_Rand
+    { "GetThreadArgs", GetThreadArgsHandler },      //SC_GetThreadArgs
+    { "PrintString", PrintStringHandler },          //SC_PrintString
+    { "PrintNum", PrintNumHandler },                //SC_PrintNum
+    { "PrintNl", PrintNlHandler },                  //SC_PrintNl
+    { "CreateMonitor", CreateMonitorHandler },      //SC_CreateMonitor
+    { "GetMonitor", GetMonitorHandler },            //SC_GetMonitor
+    { "SetMonitor", SetMonitorHandler },            //SC_SetMonitor
+    { "DestroyMonitor", DestroyMonitorHandler },    //SC_DestroyMonitor
+    { "Sleep", SleepHandler },                      //SC_Sleep
+    { "JoinThread", JoinThreadHandler },            //SC_JoinThread
+    { "Printf", PrintfHandler },                    //SC_Printf
+    { "ReadV", ReadVHandler },                      //SC_ReadV
+    { "WriteV", WriteVHandler },                    //SC_WriteV
+    { "GetMonitorRange", GetMonitorRangeHandler },  //SC_GetMonitorRange
+    { "SetMonitorRange", SetMonitorRangeHandler },  //SC_SetMonitorRange
+    { "CompareAndSwapMonitor", CompareAndSwapMonitorHandler }, //SC_CompareAndSwapMonitor
+    { "FetchAndAddMonitor", FetchAndAddMonitorHandler }, //SC_FetchAndAddMonitor
+};
+
+#define NumSyscalls ((int) (sizeof(syscallTable) / sizeof(syscallTable[0])))
+
 void ExceptionHandler(ExceptionType which) {
     int type = machine->ReadRegister(2); // Which syscall?
     int rv=0; 	// the return value from a syscall
-    int virtualAddress = 0;
 
     if ( which == SyscallException ) {
-    	switch (type) {
-        default:
-          DEBUG('a', "Unknown syscall - shutting down.\n");
-        case SC_Halt:
-            DEBUG('a', "Shutdown, initiated by user program.\n      ");
-            //cout << "Halt is called by: " << currentThread->getName() << ", number of threads remaining in space: " << currentThread->space->threadCount <<  endl;
-            currentThread->space->PrintPageTable();
-
-            interrupt->Halt();
-            break;
-        case SC_Create:
-            DEBUG('a', "Create syscall.\n");
-            Create_Syscall(machine->ReadRegister(4), machine->ReadRegister(5));
-            break;
-        case SC_Open:
-            DEBUG('a', "Open syscall.\n");
-            rv = Open_Syscall(machine->ReadRegister(4), machine->ReadRegister(5));
-            break;
-
-        case SC_Write:
-            DEBUG('a', "Write syscall.\n");
-            Write_Syscall(machine->ReadRegister(4),
-                  machine->ReadRegister(5),
-                  machine->ReadRegister(6));
-            break;
-        case SC_Read:
-            DEBUG('a', "Read syscall.\n");
-            rv = Read_Syscall(machine->ReadRegister(4),
-                  machine->ReadRegister(5),
-                  machine->ReadRegister(6));
-            break;
-        case SC_Close:
-            DEBUG('a', "Close syscall.\n");
-            Close_Syscall(machine->ReadRegister(4));
-            break;
-        case SC_Yield:
-            DEBUG('a', "Yield syscall.\n");
-            currentThread->Yield();
-            break;
-        case SC_Fork:
-            //Fork creates a new thread in the same address space
-            kernelLock->Acquire();
-            DEBUG('a', "Fork syscall.\n");
-            virtualAddress = machine->ReadRegister(4);
-            Thread* kernelThread = new Thread("KernelThread");
-            threadArgs[kernelThread->id] = machine->ReadRegister(5);
-            kernelThread->space = currentThread->space;
-            ++(currentThread->space->threadCount);
-            int startStackLocation = kernelThread->space->NewPageTable();
-            currentThread->space->RestoreState();
-            processTable->processEntries[currentThread->space->processId]->stackLocations[kernelThread->id] = startStackLocation;
-
-            kernelThread->Fork((VoidFunctionPtr)kernel_thread, virtualAddress);
-            kernelLock->Release();
-            break;
-        case SC_Exec:
-            //Exec instantiates a new user program
-            DEBUG('a', "Exec syscall.\n");
-            kernelLock->Acquire();
-            //Increasing the process table count
-            processTable->runningProcessCount += 1;
-            virtualAddress = machine->ReadRegister(4);
-            char* nameOfProcess = new char[32 + 1];
-              if(copyin(virtualAddress, 32, nameOfProcess) == -1) {// Convert it to the physical address // read the contents from physical address, which will give you the name of the process to be executed
-                DEBUG('a', "Copyin failed.\n");
-                kernelLock->Release();
-                return;
-            }
-            nameOfProcess[32] = '\0';
-            OpenFile *filePointer = fileSystem->Open(nameOfProcess);
-
-            if (filePointer){ // check if pointer is not null
-              AddrSpace* as = new AddrSpace(filePointer); // Create new addrespace for this executable file
-              delete [] nameOfProcess; //TODO: MOVE THIS DELETE AROUND< PLS
-              Thread* newThread = new Thread("ExecThread");
-              newThread->space = as; //Allocate the space created to this thread's space
-              processTable->processEntries[processCount] = new ProcessEntry();
-              processTable->processEntries[processCount]->space = as;
-              processTable->processEntries[processCount]->spaceId = processCount;
-              processTable->processEntries[newThread->space->processId]->stackLocations[newThread->id] = as->StackTopForMain;
-              rv = newThread->space->spaceId;
-              newThread->Fork((VoidFunctionPtr)exec_thread, 0);
-              kernelLock->Release();
-            }else{
-                printf("%s", "Couldn't open file\n");
-                kernelLock->Release();
-                break;
-            }
-
-            break;
-        case SC_Exit:
-            kernelLock->Acquire();
-            //Prints the result of the exit to the user program
-            printf("-----------Exit Output: %d\n", machine->ReadRegister(4));
-            //Checks for last process and last thread
-            bool isLastProcessVar = isLastProcess();
-            bool isLastExecutingThreadVar = isLastExecutingThread(currentThread);
-            if(isLastProcessVar && isLastExecutingThreadVar) {
-            //This is the last process and last thread, can stop program
-                DEBUG('a', "Last process and last thread, stopping program.\n");
-                interrupt->Halt();
-            } else if(!isLastProcessVar && isLastExecutingThreadVar) {
-            //This is the last thread in a process, but not the last process, so we delete the entire addressspace
-                  DEBUG('a', "Not last process and last thread, deleting process.\n");
-                  cout << "Not last process and last thread, deleting process.\n" ;
-                  delete currentThread->space;
-                  processTable->runningProcessCount -= 1;
-
-                  kernelLock->Release();
-                  currentThread->Finish();
-
-            }else if(!isLastExecutingThreadVar) {
-              //Not last thread in process, so just delete thread
-              DEBUG('a', "Not last thread in a process, deleting thread.\n");
-              currentThread->space->DeleteCurrentThread();
-              kernelLock->Release();
-              currentThread->Finish();
-            }
-            break;
-        case SC_CreateLock:
-            DEBUG('a', "CreateLock syscall.\n");
-            rv = CreateLock_sys(machine->ReadRegister(4),
-                                machine->ReadRegister(5),
-                                machine->ReadRegister(6));
-            break;
-        case SC_Acquire:
-            DEBUG('a', "Acquire syscall.\n");
-            Acquire_sys(machine->ReadRegister(4));
-            break;
-        case SC_Release:
-            DEBUG('a', "Release syscall.\n");
-            Release_sys(machine->ReadRegister(4));
-            break;
-        case SC_DestroyLock:
-            DEBUG('a', "DestroyLock syscall.\n");
-            DestroyLock_sys(machine->ReadRegister(4));
-            break;
-        case SC_CreateMonitor:
-            DEBUG('a', "CreateMonitor syscall.\n");
-            rv = CreateMonitor_sys(machine->ReadRegister(4),
-                                machine->ReadRegister(5),
-                                machine->ReadRegister(6));
-            break;
-        case SC_GetMonitor:
-            DEBUG('a', "GetMonitor syscall.\n");
-            rv = GetMonitor_sys(machine->ReadRegister(4),
-                          machine->ReadRegister(5));
-            break;
-        case SC_SetMonitor:
-            DEBUG('a', "SetMonitor syscall.\n");
-            SetMonitor_sys(machine->ReadRegister(4),
-                            machine->ReadRegister(5),
-                            machine->ReadRegister(6));
-            break;
-        case SC_DestroyMonitor:
-            DEBUG('a', "DestroyMonitor syscall.\n");
-            DestroyMonitor_sys(machine->ReadRegister(4));
-            break;
-        case SC_CreateCondition:
-            DEBUG('a', "CreateCondition syscall.\n");
-            rv = CreateCondition_sys(machine->ReadRegister(4),
-                                machine->ReadRegister(5),
-                                machine->ReadRegister(6));
-            break;
-        case SC_Wait:
-            DEBUG('a', "Wait syscall.\n");
-            Wait_sys(machine->ReadRegister(4), machine->ReadRegister(5));
-            break;
-        case SC_Signal:
-            DEBUG('a', "Signal syscall.\n");
-            Signal_sys(machine->ReadRegister(4), machine->ReadRegister(5));
-            break;
-        case SC_Broadcast:
-            DEBUG('a', "Broadcast syscall.\n");
-            Broadcast_sys(machine->ReadRegister(4), machine->ReadRegister(5));
-            break;
-        case SC_DestroyCondition:
-            DEBUG('a', "DestroyCondition syscall.\n");
-            DestroyCondition_sys(machine->ReadRegister(4));
-            break;
-        case SC_Rand:
-            DEBUG('a', "Rand syscall.\n");
-            rv = Rand_sys(machine->ReadRegister(4), machine->ReadRegister(5));
-            break;
-        case SC_GetThreadArgs:
-            DEBUG('a', "Get Thread Args syscall.\n");
-            rv = GetThreadArgs_sys();
-            break;
-        case SC_PrintString:
-            DEBUG('a', "Print String syscall.\n");
-            PrintString_sys(machine->ReadRegister(4), machine->ReadRegister(5));
-            break;
-        case SC_PrintNum:
-            DEBUG('a', "Print Num syscall.\n");
-            PrintNum_sys(machine->ReadRegister(4));
-            break;
-        case SC_PrintNl:
-            DEBUG('a', "Print Nl syscall.\n");
-            PrintNl_sys();
-            break;
+        if (type < 0 || type >= NumSyscalls) {
+            DEBUG('a', "Unknown syscall - shutting down.\n");
+            type = SC_Halt;
         }
+        SyscallEntry* entry = &syscallTable[type];
+        DEBUG('a', "%s syscall.\n", entry->name);
+
+        //Time the syscall, from the trap to the return to user mode (this includes any time it is blocked)
+        stats->StartSyscall(type, entry->name);
+        int64_t startTicks = stats->totalTicks;
+        double startHostTime = HostSeconds();
+        rv = (*entry->handler)(machine->ReadRegister(4),
+                               machine->ReadRegister(5),
+                               machine->ReadRegister(6));
+        stats->FinishSyscall(type, stats->totalTicks - startTicks,
+                             HostSeconds() - startHostTime);
 	// Put in the return value and increment the PC
 	machine->WriteRegister(2,rv);
 	machine->WriteRegister(PrevPCReg,machine->ReadRegister(PCReg));
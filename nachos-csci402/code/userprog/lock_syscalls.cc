@@ -14,11 +14,52 @@
 #define BUFFER_SIZE 32
 
 // +++++++++++++++++++++++++ UTILITY +++++++++++++++++++++++++
+// the mailbox the current thread gets its replies from the server in.  a thread takes one on its
+// first request and keeps it until it exits, so that the threads of one machine can all be waiting
+// on the server at once without getting each other's replies (the server also tells them apart by it)
+int currentReplyMailbox() {
+    if(currentThread->replyMailbox == -1) {
+        replyMailboxesFree->P(); // wait for a thread to exit if they are all taken
+        currentThread->replyMailbox = replyMailboxMap->Find();
+    }
+    return currentThread->replyMailbox;
+}
+
+// give the current thread's reply mailbox back when it exits
+void releaseReplyMailbox() {
+    if(currentThread->replyMailbox != -1) {
+        replyMailboxMap->Clear(currentThread->replyMailbox);
+        currentThread->replyMailbox = -1;
+        replyMailboxesFree->V();
+    }
+}
+
+// which server a request goes to.  the servers are machines 0 to numServers - 1.  an entity is created
+// on the server its name hashes to, and the index that server gives it tells which server that was
+// (index % numServers).  condition operations go to the condition's server, whichever the lock's is
+int serverForRequest(char* serverCode, char name[], int entityIndex1, int entityIndex2) {
+    if(serverCode[2] == 'C') { // a Create
+        unsigned int hash = 5381;
+        for(char* c = name; *c != '\0'; ++c) {
+            hash = hash * 33 + (unsigned char) *c;
+        }
+        return hash % numServers;
+    }
+    int index = entityIndex1;
+    if(serverCode[0] == 'C' && serverCode[2] != 'D') { // Wait, Signal, Broadcast: lock then condition
+        index = entityIndex2;
+    }
+    if(index < 0) { // a bad index; any server will say so
+        return 0;
+    }
+    return index % numServers;
+}
+
 // generic function that allows us to send any message to the server
 void sendToServer(PacketHeader &pktHdr, MailHeader &mailHdr, char* serverCode, char name[], int entityIndex1, int entityIndex2, int entityIndex3) {
     mailHdr.to = 0;
-    mailHdr.from = 0;
-    pktHdr.to = 0;
+    mailHdr.from = currentReplyMailbox();
+    pktHdr.to = serverForRequest(serverCode, name, entityIndex1, entityIndex2);
 
     stringstream ss;
 	ss << serverCode;
@@ -30,10 +71,16 @@ void sendToServer(PacketHeader &pktHdr, MailHeader &mailHdr, char* serverCode, c
 		ss << name;
 	} else {
 		ss << entityIndex1 << ' ' << entityIndex2 << ' ' << entityIndex3;
+		if(name[0] != '\0') { // any more arguments, eg, the values of a SetMonitorRange
+			ss << ' ' << name;
+		}
 	}
 
 	string str = ss.str();
-	char sendBuffer[64];
+	if(str.size() >= MaxMessageSize) { // a name too long for one message is cut short
+		str.resize(MaxMessageSize - 1);
+	}
+	char sendBuffer[MaxMessageSize];
 
 	for(unsigned int i = 0; i < str.size(); ++i) {
 		sendBuffer[i] = str.at(i);
@@ -53,8 +100,8 @@ void sendToServer(PacketHeader &pktHdr, MailHeader &mailHdr, char* serverCode, c
 
 // generic function that allows us to receive any message to the server
 string getFromServer(PacketHeader &pktHdr, MailHeader &mailHdr) {
-	char inBuffer[64];
-    postOffice->Receive(0, &pktHdr, &mailHdr, inBuffer);
+	char inBuffer[MaxMessageSize];
+    postOffice->Receive(currentReplyMailbox(), &pktHdr, &mailHdr, inBuffer);
     stringstream ss;
     ss << inBuffer;
     return ss.str();
@@ -102,25 +149,333 @@ int CreateLock_sys(int vaddr, int size, int appendNum) {
 	return currentLockIndex;
 }
 
+// ++++++++++++++++++++++ LOCK CACHE ++++++++++++++++++++++++
+// with -lc the server grants a lock to this machine instead of to one of its threads.  we keep it
+// after our threads release it, so taking it again is a local operation, and give it back once the
+// server revokes it because another machine wants it.  a lock that is waited on with a condition is
+// handed to the waiting thread and not cached again, since the condition releases it for that thread.
+// whether or not -lc is given, the server also grants a lock to the lock cache for a group of our
+// threads that one Broadcast woke, and the cache passes it from one to the next before giving it back
+
+#define LOCK_CACHE_SIZE 256 // locks with a higher global index always go to the server
+
+struct CachedLock {
+    bool cached;      // the server has granted the lock to this machine
+    bool requested;   // one of our threads has asked the server for it
+    bool revoked;     // the server wants it back as soon as no thread here holds it
+    bool uncacheable; // used with a condition (or not a lock at all): always go to the server
+    int waiting;      // our threads waiting to take it
+    int holder;       // reply mailbox of the thread of ours holding it, or -1
+    int wakeups[NumMailboxes]; // reply mailboxes of the threads woken by a Broadcast, to hand it to in turn
+    int wakeupNext, wakeupCount;
+};
+
+CachedLock cachedLocks[LOCK_CACHE_SIZE];
+PacketHeader wakeupPktHdr; // headers for the replies we give the threads woken by a Broadcast
+MailHeader wakeupMailHdr;
+Lock* lockCacheLock;         // protects cachedLocks
+Condition* lockCacheChanged; // signalled when a cached lock is granted, released or given back
+int lockCacheHits = 0;       // acquires that did not need the server
+
+// send a lock request from one of our mailboxes without waiting for the answer.  requests from the lock
+// cache's mailbox get their answer and any later revoke sent to the lock cache thread, and make the server
+// see this machine as the lock owner
+void sendLockRequestFrom(int mailbox, char* serverCode, int lockIndex) {
+    PacketHeader pktHdr;
+    MailHeader mailHdr;
+    stringstream ss;
+    ss << serverCode << lockIndex << " -1 -1";
+    string str = ss.str();
+
+    pktHdr.to = serverForRequest(serverCode, "", lockIndex, -1);
+    mailHdr.to = 0;
+    mailHdr.from = mailbox;
+    mailHdr.length = str.size() + 1;
+    if(!postOffice->Send(pktHdr, mailHdr, (char*) str.c_str())) {
+        printf("Client::The postOffice Send failed. You must not have the other Nachos running. Terminating Nachos.\n");
+        interrupt->Halt();
+    }
+}
+
+// give a cached lock back to the server.  lockCacheLock must be held
+void returnCachedLock(int lockIndex) {
+    cachedLocks[lockIndex].cached = FALSE;
+    cachedLocks[lockIndex].revoked = FALSE;
+    sendLockRequestFrom(LockCacheMailbox, "L R ", lockIndex);
+}
+
+// are there threads woken by a Broadcast still to get this cached lock?  lockCacheLock must be held
+bool wakeupsPending(CachedLock &entry) {
+    return entry.wakeupNext < entry.wakeupCount;
+}
+
+// hand a cached lock to the next thread a Broadcast woke: it is waiting in Wait for its reply, so the
+// reply is put straight in its mailbox.  lockCacheLock must be held
+void handToWokenThread(CachedLock &entry) {
+    int mailbox = entry.wakeups[entry.wakeupNext++];
+    char* reply = "Finished Waiting!";
+    entry.holder = mailbox;
+    wakeupMailHdr.to = mailbox;
+    wakeupMailHdr.length = strlen(reply) + 1;
+    postOffice->Deliver(mailbox, wakeupPktHdr, wakeupMailHdr, reply);
+}
+
+// the lock cache thread: takes the server's grants (LockCacheGrant and the index), grants for the threads
+// a Broadcast woke (LockCacheGroupGrant, the index and their mailboxes) and revokes (LockCacheRevoke).
+// the server's answers to the locks we give back need nothing done
+void LockCacheThread(int unused) {
+    char buffer[MaxMessageSize];
+    PacketHeader pktHdr;
+    MailHeader mailHdr;
+
+    while(true) {
+        postOffice->Receive(LockCacheMailbox, &pktHdr, &mailHdr, buffer);
+        stringstream ss;
+        ss << buffer;
+        string code;
+        int lockIndex = -1;
+        ss >> code;
+        if(code != LockCacheGrant && code != LockCacheGroupGrant && code != LockCacheRevoke &&
+            code != LockCacheNoLock) {
+            continue;
+        }
+        ss >> lockIndex;
+        if(lockIndex < 0 || lockIndex >= LOCK_CACHE_SIZE) {
+            continue;
+        }
+
+        CachedLock &entry = cachedLocks[lockIndex];
+        lockCacheLock->Acquire();
+        if(code == LockCacheGrant) { // granted (or, if we already have it, a revoke sent before still stands)
+            if(!entry.cached) {
+                entry.revoked = FALSE;
+            }
+            entry.cached = TRUE;
+            entry.requested = FALSE;
+        } else if(code == LockCacheGroupGrant) { // granted for woken threads, which have it first
+            entry.cached = TRUE;
+            entry.revoked = FALSE;
+            entry.wakeupNext = 0;
+            entry.wakeupCount = 0;
+            int mailbox;
+            while(entry.wakeupCount < NumMailboxes && ss >> mailbox) {
+                entry.wakeups[entry.wakeupCount++] = mailbox;
+            }
+            wakeupPktHdr = pktHdr;
+            wakeupMailHdr = mailHdr;
+            if(wakeupsPending(entry)) {
+                handToWokenThread(entry);
+            }
+        } else if(code == LockCacheNoLock) { // no such lock; let the server say so to the thread
+            entry.requested = FALSE;
+            entry.uncacheable = TRUE;
+        } else if(entry.cached) { // revoked: keep it only until the threads already waiting have had it
+            if(entry.holder == -1 && entry.waiting == 0) {
+                returnCachedLock(lockIndex);
+            } else {
+                entry.revoked = TRUE;
+            }
+        }
+        lockCacheChanged->Broadcast(lockCacheLock);
+        lockCacheLock->Release();
+    }
+}
+
+// set up the lock cache: called from Initialize
+void StartLockCache() {
+    for(int i = 0; i < LOCK_CACHE_SIZE; ++i) {
+        cachedLocks[i].holder = -1;
+    }
+    lockCacheLock = new Lock("lock cache");
+    lockCacheChanged = new Condition("lock cache changed");
+    replyMailboxMap->Mark(LockCacheMailbox); // not a reply mailbox any more
+    replyMailboxesFree->P();
+    Thread* cacheThread = new Thread("lock cache");
+    cacheThread->Fork(LockCacheThread, 0);
+}
+
+// take a lock through the lock cache, asking the server for it only if this machine does not have it.
+// false if the lock must go to the server as usual
+bool acquireCachedLock(int lockIndex) {
+    if(!useLockCache || lockIndex < 0 || lockIndex >= LOCK_CACHE_SIZE) {
+        return FALSE;
+    }
+    CachedLock &entry = cachedLocks[lockIndex];
+    lockCacheLock->Acquire();
+    bool hit = entry.cached;
+    while(!entry.uncacheable && !(entry.cached && entry.holder == -1 && !wakeupsPending(entry))) {
+        if(!entry.cached && !entry.requested) {
+            entry.requested = TRUE;
+            sendLockRequestFrom(LockCacheMailbox, "L G ", lockIndex);
+        }
+        ++entry.waiting;
+        lockCacheChanged->Wait(lockCacheLock);
+        --entry.waiting;
+    }
+    if(entry.uncacheable) {
+        lockCacheLock->Release();
+        return FALSE;
+    }
+    entry.holder = currentReplyMailbox();
+    if(hit) {
+        ++lockCacheHits;
+        DEBUG('l', "Lock cache: %d acquires without the server\n", lockCacheHits);
+    }
+    lockCacheLock->Release();
+    return TRUE;
+}
+
+// release a lock held through the lock cache: hand it to the next thread a Broadcast woke, or else give
+// it back to the server if it was revoked (or is not to be kept).  false if the current thread does not
+// hold it that way
+bool releaseCachedLock(int lockIndex) {
+    if(lockIndex < 0 || lockIndex >= LOCK_CACHE_SIZE) {
+        return FALSE;
+    }
+    CachedLock &entry = cachedLocks[lockIndex];
+    lockCacheLock->Acquire();
+    if(entry.holder == -1 || entry.holder != currentThread->replyMailbox) {
+        lockCacheLock->Release();
+        return FALSE;
+    }
+    entry.holder = -1;
+    if(wakeupsPending(entry)) {
+        handToWokenThread(entry);
+    } else if(entry.revoked || entry.uncacheable || !useLockCache) {
+        returnCachedLock(lockIndex);
+    }
+    lockCacheChanged->Broadcast(lockCacheLock);
+    lockCacheLock->Release();
+    return TRUE;
+}
+
+// stop caching a lock, which is about to be waited on with a condition or destroyed.  if the current
+// thread holds it through the cache the server is told that the thread holds it now, and the threads a
+// Broadcast woke that have not had it yet ask the server for it themselves; if no one holds it it goes
+// back to the server.  lockCacheLock is not held while we wait for the server: the entry is marked
+// uncacheable and still has us as its holder, so no other thread takes or gives back the lock meanwhile
+void uncacheLock(int lockIndex) {
+    if(lockIndex < 0 || lockIndex >= LOCK_CACHE_SIZE) {
+        return;
+    }
+    CachedLock &entry = cachedLocks[lockIndex];
+    lockCacheLock->Acquire();
+    entry.uncacheable = TRUE;
+    if(entry.cached && entry.holder != -1 && entry.holder == currentThread->replyMailbox) {
+        lockCacheLock->Release();
+        string receivedString = sendAndRecieveMessage("L H ", "", lockIndex, -1, -1);
+        lockCacheLock->Acquire();
+        entry.holder = -1;
+        entry.cached = FALSE;
+        entry.revoked = FALSE;
+        while(wakeupsPending(entry)) { // their reply is "You got the lock!" now
+            sendLockRequestFrom(entry.wakeups[entry.wakeupNext++], "L A ", lockIndex);
+        }
+    } else if(entry.cached && entry.holder == -1 && !wakeupsPending(entry)) {
+        returnCachedLock(lockIndex);
+    }
+    lockCacheChanged->Broadcast(lockCacheLock);
+    lockCacheLock->Release();
+}
+
 // acquire lock syscall
 void Acquire_sys(int lockIndex) {
+    if(acquireCachedLock(lockIndex)) {
+        return;
+    }
 	string receivedString = sendAndRecieveMessage("L A ", "", lockIndex, -1, -1);
     cout << "Acquire::receivedString: " << receivedString << endl;
 }
 
 // release lock syscall
 void Release_sys(int lockIndex) {
+    if(releaseCachedLock(lockIndex)) {
+        return;
+    }
 	string receivedString = sendAndRecieveMessage("L R ", "", lockIndex, -1, -1);
     cout << "Release::receivedString: " << receivedString << endl;
 }
 
 void DestroyLock_sys(int lockIndex) {
+    uncacheLock(lockIndex);
 	string receivedString = sendAndRecieveMessage("L D ", "", lockIndex, -1, -1);
     cout << "DestroyLock::receivedString: " << receivedString << endl;
 }
 
 // ++++++++++++++++++++ MONITORS ++++++++++++++++++++++++
 
+// with -mc N a GetMonitor leases the value from the server for N ticks, and later GetMonitors of it on
+// this machine are answered here until the lease ends or the server says the monitor was set ("U" and
+// its index).  our own writes to a monitor forget its values at once
+
+#define MONITOR_CACHE_SIZE 64 // monitors with a higher global index are not cached
+
+struct CachedMonitorValue {
+    bool valid;
+    int value;
+    int64_t expires; // tick the lease ends
+};
+
+CachedMonitorValue cachedMonitorValues[MONITOR_CACHE_SIZE][MaxMonitorRange];
+int cachedMonitorGeneration[MONITOR_CACHE_SIZE]; // counts invalidations, so a reply that crossed one is not kept
+Lock* monitorCacheLock;                           // protects the two above
+int monitorCacheHits = 0;                         // GetMonitors that did not need the server
+
+// forget the cached values of a monitor.  monitorCacheLock must be held
+void forgetCachedMonitor(int monitorIndex) {
+    for(int i = 0; i < MaxMonitorRange; ++i) {
+        cachedMonitorValues[monitorIndex][i].valid = FALSE;
+    }
+    ++cachedMonitorGeneration[monitorIndex];
+}
+
+// the monitor cache thread: takes the server's invalidations
+void MonitorCacheThread(int unused) {
+    char buffer[MaxMessageSize];
+    PacketHeader pktHdr;
+    MailHeader mailHdr;
+
+    while(true) {
+        postOffice->Receive(MonitorCacheMailbox, &pktHdr, &mailHdr, buffer);
+        stringstream ss;
+        ss << buffer;
+        char code = '\0';
+        int monitorIndex = -1;
+        ss >> code >> monitorIndex;
+        if(code != 'U' || monitorIndex < 0 || monitorIndex >= MONITOR_CACHE_SIZE) {
+            continue;
+        }
+        monitorCacheLock->Acquire();
+        forgetCachedMonitor(monitorIndex);
+        monitorCacheLock->Release();
+    }
+}
+
+// set up the monitor cache: called from Initialize when -mc is given
+void StartMonitorCache() {
+    monitorCacheLock = new Lock("monitor cache");
+    replyMailboxMap->Mark(MonitorCacheMailbox); // not a reply mailbox any more
+    replyMailboxesFree->P();
+    Thread* cacheThread = new Thread("monitor cache");
+    cacheThread->Fork(MonitorCacheThread, 0);
+}
+
+// can this monitor value be cached?
+bool monitorIsCacheable(int monitorIndex, int arrayIndex) {
+    return monitorLeaseTicks > 0 && monitorIndex >= 0 && monitorIndex < MONITOR_CACHE_SIZE &&
+        arrayIndex >= 0 && arrayIndex < MaxMonitorRange;
+}
+
+// a thread of ours is changing a monitor: forget its cached values
+void invalidateCachedMonitor(int monitorIndex) {
+    if(!monitorIsCacheable(monitorIndex, 0)) {
+        return;
+    }
+    monitorCacheLock->Acquire();
+    forgetCachedMonitor(monitorIndex);
+    monitorCacheLock->Release();
+}
+
 // create monitor syscall
 int CreateMonitor_sys(int vaddr, int size, int arraySize) {
 	char* name = new char[size + 1]; //allocate new char array
@@ -151,24 +506,140 @@ int CreateMonitor_sys(int vaddr, int size, int arraySize) {
 
 // get monitor syscall
 int GetMonitor_sys(int monitorIndex, int arrayIndex) {
-	string receivedString = sendAndRecieveMessage("M G ", "", monitorIndex, arrayIndex, -1);
+    string receivedString;
+    int generation = 0;
+    if(monitorIsCacheable(monitorIndex, arrayIndex)) {
+        monitorCacheLock->Acquire();
+        CachedMonitorValue &cached = cachedMonitorValues[monitorIndex][arrayIndex];
+        if(cached.valid && stats->totalTicks < cached.expires) {
+            int value = cached.value;
+            ++monitorCacheHits;
+            DEBUG('l', "Monitor cache: %d GetMonitors without the server\n", monitorCacheHits);
+            monitorCacheLock->Release();
+            return value;
+        }
+        generation = cachedMonitorGeneration[monitorIndex];
+        monitorCacheLock->Release();
+        receivedString = sendAndRecieveMessage("M L ", "", monitorIndex, arrayIndex, monitorLeaseTicks);
+    } else {
+        receivedString = sendAndRecieveMessage("M G ", "", monitorIndex, arrayIndex, -1);
+    }
     cout << "Client::GetMonitor::receivedString: "  <<  endl;
     int value;
     stringstream ss;
     ss << receivedString;
-    ss >> value;
+    if((ss >> value) && monitorIsCacheable(monitorIndex, arrayIndex)) {
+        monitorCacheLock->Acquire();
+        if(generation == cachedMonitorGeneration[monitorIndex]) { // not set since we asked
+            CachedMonitorValue &cached = cachedMonitorValues[monitorIndex][arrayIndex];
+            cached.valid = TRUE;
+            cached.value = value;
+            cached.expires = stats->totalTicks + monitorLeaseTicks;
+        }
+        monitorCacheLock->Release();
+    }
     // cout << "Got Monitor value: " << value << endl;
     return value;
 }
 
 // set monitor syscall
 void SetMonitor_sys(int monitorIndex, int arrayIndex, int value) {
+    invalidateCachedMonitor(monitorIndex);
 	string receivedString = sendAndRecieveMessage("M S ", "", monitorIndex, arrayIndex, value);
   cout << "Client::SetMonitor::receivedString: " << receivedString <<  ' ' << monitorIndex << ' ' << arrayIndex << ' '<< value << endl;
 }
 
 // destroy monitor syscall
 void DestroyMonitor_sys(int monitorIndex) {
+    invalidateCachedMonitor(monitorIndex);
 	string receivedString = sendAndRecieveMessage("M D ", "", monitorIndex, -1, -1);
      cout << "Client::DestroyMonitor::receivedString: " << receivedString << endl;
 }
+
+// get monitor range syscall.  one request brings back "count" values, which are
+// copied out to the user's array at vaddr
+int GetMonitorRange_sys(int monitorIndex, int first, int count, int vaddr) {
+    if(count < 0 || count > MaxMonitorRange) {
+        printf("GetMonitorRange: count %d must be 0 to %d\n", count, MaxMonitorRange);
+        return -1;
+    }
+	string receivedString = sendAndRecieveMessage("M R ", "", monitorIndex, first, count);
+    stringstream ss;
+    ss << receivedString;
+    int values[MaxMonitorRange];
+    for(int i = 0; i < count; ++i) {
+        int value;
+        if(!(ss >> value)) { // the server sent back an error
+            cout << "Client::GetMonitorRange::receivedString: " << receivedString << endl;
+            return -1;
+        }
+        values[i] = WordToMachine(value); // going out to the user's array
+    }
+    if(copyout(vaddr, count * sizeof(int), (char*) values) == -1) {
+        DEBUG('l',"%s"," COPYOUT FAILED\n");
+        return -1;
+    }
+    return count;
+}
+
+// set monitor range syscall.  the values from the user's array at vaddr go to the
+// server in one request
+int SetMonitorRange_sys(int monitorIndex, int first, int count, int vaddr) {
+    if(count < 0 || count > MaxMonitorRange) {
+        printf("SetMonitorRange: count %d must be 0 to %d\n", count, MaxMonitorRange);
+        return -1;
+    }
+    int values[MaxMonitorRange];
+    if(copyin(vaddr, count * sizeof(int), (char*) values) == -1) {
+        DEBUG('l',"%s"," COPYIN FAILED\n");
+        return -1;
+    }
+    stringstream valuesString;
+    for(int i = 0; i < count; ++i) {
+        valuesString << (int) WordToHost(values[i]) << ' ';
+    }
+    string str = valuesString.str();
+    invalidateCachedMonitor(monitorIndex);
+	string receivedString = sendAndRecieveMessage("M W ", (char*) str.c_str(), monitorIndex, first, count);
+    stringstream ss;
+    ss << receivedString;
+    int setCount = -1;
+    if(!(ss >> setCount)) { // the server sent back an error
+        cout << "Client::SetMonitorRange::receivedString: " << receivedString << endl;
+        return -1;
+    }
+    return setCount;
+}
+
+// the value in an atomic monitor call's reply ("OK" and the value), or MonitorError if the server
+// sent back an error instead
+int atomicMonitorReply(char* call, string receivedString) {
+    stringstream ss;
+    ss << receivedString;
+    string status;
+    int value;
+    if(!(ss >> status >> value) || status != "OK") {
+        cout << "Client::" << call << "::receivedString: " << receivedString << endl;
+        return MonitorError;
+    }
+    return value;
+}
+
+// compare and swap monitor syscall.  returns the value the monitor had; the swap
+// happened if that is "expected".  MonitorError if the server refused it
+int CompareAndSwapMonitor_sys(int monitorIndex, int arrayIndex, int expected, int newValue) {
+    stringstream newValueString;
+    newValueString << newValue;
+    string str = newValueString.str();
+    invalidateCachedMonitor(monitorIndex);
+	string receivedString = sendAndRecieveMessage("M X ", (char*) str.c_str(), monitorIndex, arrayIndex, expected);
+    return atomicMonitorReply("CompareAndSwapMonitor", receivedString);
+}
+
+// fetch and add monitor syscall.  returns the value the monitor had before the add, or
+// MonitorError if the server refused it
+int FetchAndAddMonitor_sys(int monitorIndex, int arrayIndex, int amount) {
+    invalidateCachedMonitor(monitorIndex);
+	string receivedString = sendAndRecieveMessage("M F ", "", monitorIndex, arrayIndex, amount);
+    return atomicMonitorReply("FetchAndAddMonitor", receivedString);
+}
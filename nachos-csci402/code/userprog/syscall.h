@@ -47,8 +47,19 @@
 #define SC_GetMonitor	26
 #define SC_SetMonitor	27
 #define SC_DestroyMonitor	28
+#define SC_Sleep	29
+#define SC_JoinThread	30
+#define SC_Printf	31
+#define SC_ReadV	32
+#define SC_WriteV	33
+#define SC_GetMonitorRange	34
+#define SC_SetMonitorRange	35
+#define SC_CompareAndSwapMonitor	36
+#define SC_FetchAndAddMonitor	37
 
 #define MAXFILENAME 256
+#define MaxPrintfLength 256	/* longest Printf format string, or %s string */
+#define MaxMonitorRange 50	/* most values in one Get/SetMonitorRange */
 
 #ifndef IN_ASM
 
@@ -82,7 +93,8 @@ typedef int SpaceId;
 SpaceId Exec(char *name);
 
 /* Only return once the the user program "id" has finished.
- * Return the exit status.
+ * Return the exit status (of the last thread in it to call Exit),
+ * or -1 if "id" is not a program started by Exec.
  */
 int Join(SpaceId id);
 
@@ -130,6 +142,26 @@ int Read(char *buffer, int size, OpenFileId id);
 /* Close the file, we're done reading and writing to it. */
 void Close(OpenFileId id);
 
+/* One buffer of a ReadV or WriteV: "len" bytes at "buf". */
+typedef struct {
+    char *buf;
+    int len;
+} IOVec;
+
+#define MaxIOVecs	16	/* most buffers in one ReadV or WriteV */
+#define MaxIOVecBytes	(64 * 1024)	/* most bytes in one ReadV or WriteV */
+
+/* Write the "count" buffers in "vec", in order, as if with one Write.
+ * Return the number of bytes written, or -1.
+ */
+int WriteV(IOVec *vec, int count, OpenFileId id);
+
+/* Read from the open file into the "count" buffers in "vec", filling
+ * each in turn, as if with one Read.  Return the number of bytes read
+ * (less than the total if the file ends first), or -1.
+ */
+int ReadV(IOVec *vec, int count, OpenFileId id);
+
 
 
 /* User-level thread operations: Fork and Yield.  To allow multiple
@@ -137,14 +169,25 @@ void Close(OpenFileId id);
  */
 
 /* Fork a thread to run a procedure ("func") in the *same* address space
- * as the current thread.
+ * as the current thread.  Return the new thread's id, for JoinThread.
+ */
+int Fork(void (*func)(), int threadId);
+
+/* Only return once the thread "id", forked in this address space, has
+ * called Exit.  Return its exit status, or -1 if "id" is not a thread
+ * of this address space.
  */
-void Fork(void (*func)(), int threadId);
+int JoinThread(int id);
 
 /* Yield the CPU to another runnable thread, whether in this address space
  * or not.
  */
 void Yield();
+
+/* Block the calling thread for "ticks" of simulated time, without using
+ * the CPU, instead of looping on Yield().
+ */
+void Sleep(int ticks);
 /* Redundant declaration*/
 
 int Rand(int mod, int plus);
@@ -155,6 +198,12 @@ void PrintString(char* str, int len);
 void PrintNum(int num);
 void PrintNl();
 
+/* Print "format" (NUL-terminated) to the console, with each %d, %c and
+ * %s replaced by the next argument (an int, a char, or a NUL-terminated
+ * string), and %% by %.  One trap instead of one per PrintString/PrintNum.
+ */
+void Printf(char* format, ...);
+
 int CreateLock(char* name, int size, int appendNum);
 void Acquire(int lockNumber);
 void Release(int lockNumber);
@@ -165,6 +214,24 @@ int GetMonitor(int monitorIndex, int arrayIndex);
 void SetMonitor(int monitorIndex, int arrayIndex, int value);
 void DestroyMonitor(int monitorNumber);
 
+/* Copy "count" values of a monitor array, starting at "first", into
+ * "values", or from "values" into the monitor, with one request to the
+ * server instead of one per value.  Return "count", or -1 on an error.
+ */
+int GetMonitorRange(int monitorIndex, int first, int count, int *values);
+int SetMonitorRange(int monitorIndex, int first, int count, int *values);
+
+/* Atomically on the server: set a monitor value to "newValue" if it is
+ * "expected", or add "amount" to it.  Both return the value it had before,
+ * or MonitorError if the server refused the request (a bad monitor or
+ * index).  No monitor can hold MonitorError: the server won't store it.
+ */
+#define MonitorError	(-2147483647 - 1)
+
+int CompareAndSwapMonitor(int monitorIndex, int arrayIndex, int expected,
+                          int newValue);
+int FetchAndAddMonitor(int monitorIndex, int arrayIndex, int amount);
+
 int CreateCondition(char* name, int size, int appendNum);
 void Signal(int lockNumber, int conditionNumber);
 void Wait(int lockNumber, int conditionNumber);